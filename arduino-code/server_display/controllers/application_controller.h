@@ -3,6 +3,7 @@
 
 #include "../config.h"
 #include "../managers/element_manager.h"
+#include "../managers/panel_manager.h"
 #include "../utils/eink.h"
 #include "../utils/http.h"
 #include "../utils/wifi.h"
@@ -94,38 +95,21 @@ private:
 #pragma region Private Methods (checkScreenRefresh, fetchElementsFromAPI)
 
     /**
-     * @brief Checks if the display needs to be refreshed based on the last update time.
-     * It will set the refresh type to the appropriate type based on the time since the last whole screen refresh.
-     * #define ELEMENT_REFRESH_INTERVAL 30000            // ms (30 seconds) when the page is updated (no flashing)
-     * #define DISPLAY_REFRESH_FAST_INTERVAL 150000      // ms (2.5 minutes) when the page is updated (no flashing)
-     * #define DISPLAY_REFRESH_PARTIAL_INTERVAL 300000   // ms (5 minutes) when the page is updated (with flashing)
-     * #define DISPLAY_REFRESH_COMPLETE_INTERVAL 1800000 // ms (30 minutes) when the page is updated (with flashing)
-
+     * @brief Checks if the elements need to be fetched again based on the last update time.
+     * #define ELEMENT_REFRESH_INTERVAL 30000 // ms (30 seconds) when the page is updated (no flashing)
+     *
+     * Flashing against ghosting is not timed, the panel flashes single tiles once they used up
+     * their ghosting budget (see flash_ghosted_tiles).
      */
     void checkScreenRefresh() {
         unsigned long current_time = millis();
-        unsigned long time_since_update = current_time - last_update_time;
-
-        // Store the most aggressive refresh type needed
-        RefreshType needed_refresh = NO_REFRESH;
-
-        // Check all intervals and use the most aggressive refresh type
-        if (time_since_update >= DISPLAY_REFRESH_COMPLETE_INTERVAL) {
-            needed_refresh = DISPLAY_REFRESH_COMPLETE;
-        } else if (time_since_update >= DISPLAY_REFRESH_PARTIAL_INTERVAL) {
-            needed_refresh = DISPLAY_REFRESH_PARTIAL;
-        } else if (time_since_update >= DISPLAY_REFRESH_FAST_INTERVAL) {
-            needed_refresh = DISPLAY_REFRESH_FAST;
-        } else if (time_since_update >= ELEMENT_REFRESH_INTERVAL) {
-            needed_refresh = REFETCH_ELEMENTS;
-        }
+        if (current_time - last_update_time < ELEMENT_REFRESH_INTERVAL)
+            return;
 
-        // Only update if we need a refresh and it's more aggressive than current
-        if (needed_refresh != NO_REFRESH &&
-            needed_refresh > refresh_type.load()) {
-            refresh_type.store(needed_refresh);
-            last_update_time = current_time;
-        }
+        // Only update if it's more aggressive than current
+        if (REFETCH_ELEMENTS > refresh_type.load())
+            refresh_type.store(REFETCH_ELEMENTS);
+        last_update_time = current_time;
     }
 
     /**
@@ -186,14 +170,14 @@ private:
 
 public:
 #pragma region Instantiation Methods including touch thread
-    ApplicationController(uint8_t *framebuffer, TouchDrvGT911 &touch) : framebuffer(framebuffer),
-                                                                        touch_active(false),
-                                                                        last_touch_time(0),
-                                                                        last_update_time(0),
-                                                                        touch(touch),
-                                                                        elementManager(framebuffer),
-                                                                        webServer(&refresh_type),
-                                                                        touchTaskHandle(NULL) {
+    ApplicationController(PanelManager &panel, TouchDrvGT911 &touch) : framebuffer(panel.getFramebuffer()),
+                                                                       touch_active(false),
+                                                                       last_touch_time(0),
+                                                                       last_update_time(0),
+                                                                       touch(touch),
+                                                                       elementManager(panel),
+                                                                       webServer(&refresh_type),
+                                                                       touchTaskHandle(NULL) {
         // Create the touch handling thread
         xTaskCreate(
             touchTaskWrapper, // Task function
@@ -220,7 +204,7 @@ public:
 
     /**
      * @brief Main application loop that handles:
-     * - Periodic display refresh to prevent pixel sticking (checkScreenRefresh and webServer.handleClient)
+     * - Flashing ghosted tiles to prevent pixel sticking (flash_ghosted_tiles after each draw)
      * - Fetching new data from API (checkScreenRefresh and touch events)
      * - Sending data to the element manager for processing (fetchElementsFromAPI)
      */
@@ -93,12 +93,9 @@ public:
             return;
 
         // First get text dimensions
-        int32_t x1, y1, w, h;
-        int32_t temp_x = x;
-        int32_t temp_y = y;
-        get_text_bounds((GFXfont *)&FiraSans, text,
-                        &temp_x, &temp_y,
-                        &x1, &y1, &w, &h, NULL);
+        const GlyphRun &run = getTextRun();
+        int32_t w = run.bounds.width;
+        int32_t h = run.bounds.height;
 
         // Calculate total button dimensions
         int32_t buttonWidth = w + (padding_x * 2);
@@ -172,11 +169,11 @@ public:
         }
 
         // Draw the text
-        write_mode((GFXfont *)&FiraSans, text,
-                   &text_x, &text_y,
-                   framebuffer,
-                   BLACK_ON_WHITE,
-                   &textProps);
+        write_glyph_run(&run,
+                        &text_x, &text_y,
+                        framebuffer,
+                        BLACK_ON_WHITE,
+                        &textProps);
     }
 
     void updateElement() override {
@@ -199,7 +196,9 @@ public:
         x = element["x"].as<int16_t>();
         y = element["y"].as<int16_t>();
         anchor = getAnchorFromString(element["anchor"] | "bl");
-        font_props = get_text_properties(element["level"].as<uint8_t>());
+        level = element["level"].as<uint8_t>();
+        font_props = get_text_properties(level);
+        font_id = find_font(element["font"] | "", level);
         padding_x = static_cast<int16_t>(constrain(element["padding_x"] | 10, 0, 100));
         padding_y = static_cast<int16_t>(constrain(element["padding_y"] | 5, 0, 50));
         radius = static_cast<uint16_t>(constrain(element["radius"] | 0, 0, 35));
@@ -209,8 +208,8 @@ public:
     }
 
     void drawTouched(uint8_t *framebuffer) override {
-        // TODO: Implement, invert colors of background and text
-        return;
+        LOG_D("Drawing touched button id=%d", id);
+        invert_framebuffer_area(bounds, framebuffer);
     }
 #pragma endregion
 
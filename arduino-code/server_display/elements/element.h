@@ -2,6 +2,7 @@
 #define DRAW_ELEMENT_H
 
 #include "../utils/eink.h"
+#include "../utils/fonts.h"
 #include "epd_driver.h"
 #include "firasans.h"
 #include <Arduino.h>
@@ -47,8 +48,13 @@ protected:
     Anchor anchor;             // The anchor of the element
     Rect_t bounds;             // The bounds of the element
     FontProperties font_props; // The properties of the font
+    uint8_t level;             // The text level the font properties are taken from
+    uint8_t font_id;           // The registered font the text is drawn in
     bool touched;              // Indicates if the element was touched in current update cycle
+    SavedRegion_t saved_under; // The framebuffer under the touched state, while it is shown
     RefreshType refresh_type;  // Current type of refresh to perform on the element
+    GlyphRun text_run;         // The text laid out in the element font, once it is needed
+    bool text_laid_out;        // Whether text_run holds the layout of text
 #pragma endregion
 
     static Anchor getAnchorFromString(const char *anchor) {
@@ -73,8 +79,19 @@ protected:
         return Anchor::TOP_LEFT;
     }
 
+    /**
+     * @brief Get the layout of the text, laid out on first use
+     * Elements are replaced when their content changes, so this happens once per content change
+     */
+    const GlyphRun &getTextRun() {
+        if (!text_laid_out && text) {
+            text_laid_out = layout_text(get_font(font_id), text, NULL, &text_run);
+        }
+        return text_run;
+    }
+
 public:
-    DrawElement() : id(0), text(nullptr), x(0), y(0), callback(nullptr), touched(false) {}
+    DrawElement() : id(0), text(nullptr), x(0), y(0), callback(nullptr), level(1), font_id(DEFAULT_FONT), touched(false), saved_under(), text_run(), text_laid_out(false) {}
 
     // destructor
     virtual ~DrawElement() {
@@ -84,6 +101,10 @@ public:
         if (callback) {
             free(callback);
         }
+        epd_free_region(&saved_under);
+        if (text_laid_out) {
+            free_glyph_run(&text_run);
+        }
     }
 
 #pragma region Virtual Methods not defined in the base class
@@ -105,7 +126,7 @@ public:
      * @brief Draw the element when it is touched
      * @param framebuffer The framebuffer to draw to
      */
-    virtual void drawTouched(uint8_t *framebuffer) = 0; // TODO: Implement these
+    virtual void drawTouched(uint8_t *framebuffer) = 0;
 
     // TODO: Implement this
     // This should calculate the bounds of the element based on the text, font size, etc.
@@ -118,7 +139,14 @@ public:
 
 #pragma endregion
 
-#pragma region(clearArea, isEqual) Virtual Methods defined in the base class
+#pragma region(clearArea, isEqual, applyDisplayMode) Virtual Methods defined in the base class
+
+    /**
+     * @brief Take the colors of the current display mode without reparsing the element
+     */
+    virtual void applyDisplayMode() {
+        font_props = get_text_properties(level);
+    }
 
     /**
      * @brief Clear the area of the element
@@ -241,12 +269,42 @@ public:
         return x == other.x &&
                y == other.y &&
                anchor == other.anchor &&
+               font_id == other.font_id &&
                type == other.type;
     }
 #pragma endregion
 
 #pragma region touch methods
 
+    /**
+     * @brief Save the framebuffer under the element and draw its touched state over it
+     * @param framebuffer The framebuffer to draw to
+     */
+    void showTouched(uint8_t *framebuffer) {
+        if (saved_under.data != nullptr || !callback || strlen(callback) == 0)
+            return;
+        if (!epd_save_region(bounds, framebuffer, &saved_under)) {
+            LOG_E("Failed to save area under element id %d", id);
+            return;
+        }
+        LOG_D("Saved %u bytes under element id %d", saved_under.size, id);
+        drawTouched(framebuffer);
+    }
+
+    /**
+     * @brief Put back what was under the touched state and flash the area so it can lighten
+     * @param framebuffer The framebuffer to restore to
+     */
+    void restoreTouched(uint8_t *framebuffer) {
+        if (saved_under.data == nullptr)
+            return;
+        epd_restore_region(&saved_under, framebuffer);
+        clear_area(saved_under.area, framebuffer, 1, 50, 50);
+        epd_free_region(&saved_under);
+    }
+
+    bool isShowingTouched() const { return saved_under.data != nullptr; }
+
     bool executeCallback(uint8_t *framebuffer) {
         if (!callback || strlen(callback) == 0) {
             return false;
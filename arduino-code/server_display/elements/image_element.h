@@ -51,9 +51,15 @@ private:
      * @brief Check if the image should be inverted
      */
     bool shouldInvert() {
-        // TODO: Implement, check the current background color and do the opposite
-        // or use font properties if it's updated
-        return false;
+        // Icons are drawn white on a black background, matching a remapped framebuffer
+        return img_type == ImageType::ICON && current_display.background_color == 0;
+    }
+
+    /**
+     * @brief Check if the image covers what is underneath, album art does, icons only where they are not white
+     */
+    bool isOpaque() {
+        return img_type != ImageType::ICON;
     }
 
 #pragma endregion
@@ -122,8 +128,10 @@ public:
         }
 
         bool success = false;
+        uint16_t image_flags = 0;
         if (isCardMounted()) {
-            success = readImageBufferFromSD(storage_filename, img_buffer, received_width, received_height);
+            success = readImageBufferFromSD(storage_filename, img_buffer, image_data_size,
+                                            received_width, received_height, image_flags);
         }
 
         if (!success) {
@@ -131,7 +139,10 @@ public:
             success = fetchImageFromServer(url, img_buffer, received_width, received_height,
                                            static_cast<uint32_t>(width), static_cast<uint32_t>(height));
             if (success) {
-                saveImageBufferToSD(storage_filename, img_buffer, received_width, received_height);
+                // The server sends the left pixel in the high nibble, cache it in framebuffer order
+                epd_swar_swap_buffer(img_buffer, image_data_size);
+                image_flags = IMAGE_NATIVE_ORDER;
+                saveImageBufferToSD(storage_filename, img_buffer, received_width, received_height, image_flags);
             }
         }
 
@@ -148,56 +159,18 @@ public:
             return;
         }
 
-        // Calculate byte offset for x position (2 pixels per byte)
-        uint16_t x_byte_offset = x / 2;
-        uint8_t x_pixel_offset = x % 2;
-
-        // Copy image data into framebuffer at correct position
-        for (uint32_t pos_y = 0; pos_y < height; pos_y++) {
-            for (uint32_t pos_x = 0; pos_x < width; pos_x++) {
-                // Calculate source byte and nibble
-                uint32_t src_byte_idx = (pos_y * bytes_per_row) + (pos_x / 2);
-                bool is_high_nibble = (pos_x % 2 == 0);
-                uint8_t pixel;
-
-                // Extract the pixel value (4 bits)
-                if (is_high_nibble) {
-                    pixel = (img_buffer[src_byte_idx] >> 4) & 0x0F;
-                } else {
-                    pixel = img_buffer[src_byte_idx] & 0x0F;
-                }
-
-                // Handle inversion and transparency
-                if (shouldInvert()) {
-                    if (pixel == 0x0F)
-                        pixel = 0x00;
-                    else if (pixel == 0x00)
-                        pixel = 0x0F;
-
-                    // Skip black pixels for transparency
-                    if (pixel == 0x00)
-                        continue;
-                } else {
-                    // skip white pixels for transparency
-                    if (pixel == 0x0F)
-                        continue;
-                }
-
-                // Calculate destination position
-                uint32_t dst_x = x + pos_x;
-                uint32_t dst_y = y + pos_y;
-                uint32_t dst_byte_idx = (dst_y * EPD_WIDTH / 2) + (dst_x / 2);
-                bool dst_is_high_nibble = (dst_x % 2 == 0);
-
-                // Write the pixel to the framebuffer
-                if (dst_is_high_nibble) {
-                    framebuffer[dst_byte_idx] = (framebuffer[dst_byte_idx] & 0x0F) | (pixel << 4);
-                } else {
-                    framebuffer[dst_byte_idx] = (framebuffer[dst_byte_idx] & 0xF0) | pixel;
-                }
-            }
+        // Icons are transparent where they are white, inverted icons where they are black
+        uint8_t transparent_key = 0x0F;
+        if (shouldInvert()) {
+            epd_swar_swap_levels_buffer(img_buffer, image_data_size, 0x00, 0x0F);
+            transparent_key = 0x00;
         }
 
+        // Opaque rows at an even x are copied straight into the framebuffer
+        uint32_t blit_flags = isOpaque() ? 0 : BLIT_TRANSPARENT;
+        epd_blit({.x = x, .y = y, .width = width, .height = height}, img_buffer, framebuffer,
+                 blit_flags, transparent_key);
+
         // TODO: ewwies!! maybe fix these bounds bounds calculations...
         // bounds = {
         //     .x = static_cast<int32_t>(x),
@@ -217,74 +190,12 @@ public:
         return;
     }
 
-    // TODO: Implement touch effect for image / icon
-    // Maybe get image from SD if exists and turn the non background color pixels to grey
+    /**
+     * @brief Draw the image inverted, the element manager restores the saved original afterwards
+     */
     void drawTouched(uint8_t *framebuffer) override {
-        if (img_type == ImageType::ICON) {
-            LOG_D("Drawing touched icon");
-            String storage_filename = String(name) + "_" + String(width) + "x" + String(height) + ".bin";
-            // Not really used but keeping for now
-            uint32_t received_width, received_height;
-            size_t bytes_per_row = width / 2;
-            size_t image_data_size = bytes_per_row * height;
-            uint8_t *img_buffer = (uint8_t *)malloc(image_data_size);
-            if (!img_buffer) {
-                LOG_E("Failed to allocate image buffer");
-                return;
-            }
-            bool success = false;
-            if (isCardMounted()) {
-                success = readImageBufferFromSD(storage_filename, img_buffer, received_width, received_height);
-            }
-            if (!success) {
-                free(img_buffer);
-                return;
-            }
-            // Calculate byte offset for x position (2 pixels per byte)
-            uint16_t x_byte_offset = x / 2;
-            uint8_t x_pixel_offset = x % 2;
-
-            // Copy image data into framebuffer at correct position
-            for (uint32_t pos_y = 0; pos_y < height; pos_y++) {
-                for (uint32_t pos_x = 0; pos_x < width; pos_x++) {
-                    // Calculate source byte and nibble
-                    uint32_t src_byte_idx = (pos_y * bytes_per_row) + (pos_x / 2);
-                    bool is_high_nibble = (pos_x % 2 == 0);
-                    uint8_t pixel;
-
-                    // Extract the pixel value (4 bits)
-                    if (is_high_nibble) {
-                        pixel = (img_buffer[src_byte_idx] >> 4) & 0x0F;
-                    } else {
-                        pixel = img_buffer[src_byte_idx] & 0x0F;
-                    }
-
-                    // Handle inversion and transparency
-                    if (pixel == 0x0F)
-                        pixel = 0x00;
-                    else if (pixel == 0x00)
-                        pixel = 0x0F;
-
-                    // Skip black pixels for transparency
-                    if (pixel == 0x00)
-                        continue;
-
-                    // Calculate destination position
-                    uint32_t dst_x = x + pos_x;
-                    uint32_t dst_y = y + pos_y;
-                    uint32_t dst_byte_idx = (dst_y * EPD_WIDTH / 2) + (dst_x / 2);
-                    bool dst_is_high_nibble = (dst_x % 2 == 0);
-
-                    // Write the pixel to the framebuffer
-                    if (dst_is_high_nibble) {
-                        framebuffer[dst_byte_idx] = (framebuffer[dst_byte_idx] & 0x0F) | (pixel << 4);
-                    } else {
-                        framebuffer[dst_byte_idx] = (framebuffer[dst_byte_idx] & 0xF0) | pixel;
-                    }
-                }
-            }
-            free(img_buffer);
-        }
+        LOG_D("Drawing touched image id=%d", id);
+        invert_framebuffer_area(bounds, framebuffer);
     }
 
 #pragma endregion
@@ -4,9 +4,11 @@
 #include "element.h"
 
 class TextElement : public DrawElement {
+private:
+    bool composite; // Blend the text into what is underneath, e.g. album art
 
 public:
-    TextElement() : DrawElement() {
+    TextElement() : DrawElement(), composite(false) {
         type = ElementType::TEXT;
     }
 
@@ -14,13 +16,9 @@ public:
         if (!text)
             return;
 
-        int32_t x1, y1, w, h;
-        int32_t temp_x = x;
-        int32_t temp_y = y;
-
-        get_text_bounds((GFXfont *)&FiraSans, text,
-                        &temp_x, &temp_y,
-                        &x1, &y1, &w, &h, NULL);
+        const GlyphRun &run = getTextRun();
+        int32_t w = run.bounds.width;
+        int32_t h = run.bounds.height;
 
         int32_t cursor_x = x;
         int32_t cursor_y = y;
@@ -64,11 +62,15 @@ public:
             .width = min(w, EPD_WIDTH - bounds.x),
             .height = min(h, EPD_HEIGHT - bounds.y)};
 
-        write_mode((GFXfont *)&FiraSans, text,
-                   &cursor_x, &cursor_y,
-                   framebuffer,
-                   BLACK_ON_WHITE,
-                   &font_props);
+        FontProperties props = font_props;
+        if (composite)
+            props.flags |= DRAW_COMPOSITE;
+
+        write_glyph_run(&run,
+                        &cursor_x, &cursor_y,
+                        framebuffer,
+                        BLACK_ON_WHITE,
+                        &props);
     }
 
     bool updateFromJson(JsonObject &element) override {
@@ -84,20 +86,30 @@ public:
         x = element["x"].as<int16_t>();
         y = element["y"].as<int16_t>();
         anchor = getAnchorFromString(element["anchor"] | "bl");
-        font_props = get_text_properties(element["level"].as<uint8_t>());
+        level = element["level"].as<uint8_t>();
+        font_props = get_text_properties(level);
+        font_id = find_font(element["font"] | "", level);
+        composite = element["composite"] | false;
 
         return true;
     }
 
     void drawTouched(uint8_t *framebuffer) override {
         LOG_D("Drawing touched text element id=%d", id);
-        return;
+        invert_framebuffer_area(bounds, framebuffer);
     }
 
     void updateElement() override {
         // TODO: Implement
         return;
     }
+
+    bool isEqual(const DrawElement &other) const override {
+        if (other.getType() != ElementType::TEXT)
+            return false;
+        return DrawElement::isEqual(other) &&
+               composite == static_cast<const TextElement &>(other).composite;
+    }
 };
 
 #endif // TEXT_ELEMENT_H
\ No newline at end of file
@@ -29,27 +29,24 @@
 #include "utils/types.h"
 // controllers
 #include "controllers/application_controller.h"
+#include "managers/panel_manager.h"
 
 // Physical inputs
 TouchDrvGT911 touch;
 
-// screen buffer
+// screen buffers, composed into on this core and drawn to the panel from the other
+PanelManager panel;
 
 // application controller
 ApplicationController *app;
 
 #pragma region Setup Functions
 
-// New framebuffer initialization
-std::unique_ptr<uint8_t[]> framebuffer;
+// Front and back framebuffer initialization
 void setupFramebuffer() {
-    framebuffer = std::unique_ptr<uint8_t[]>(new uint8_t[EPD_WIDTH * EPD_HEIGHT / 2]);
-    if (!framebuffer) {
-        LOG_E("Failed to allocate framebuffer memory");
+    if (!panel.begin()) {
         return;
     }
-    LOG_D("Allocated framebuffer of size %d bytes", EPD_WIDTH * EPD_HEIGHT / 2);
-    memset(framebuffer.get(), 0xFF, EPD_WIDTH * EPD_HEIGHT / 2);
     LOG_I("Framebuffer initialized successfully");
 }
 
@@ -150,7 +147,7 @@ void setup() {
     setupTouch();
     setupWiFi();
     setupSD();
-    app = new ApplicationController(framebuffer.get(), touch);
+    app = new ApplicationController(panel, touch);
     LOG_I("Initialized successfully");
 }
 
@@ -7,12 +7,16 @@
 #include "../elements/element.h"
 #include "../elements/image_element.h"
 #include "../elements/text_element.h"
+#include "epd_text_cache.h"
+#include "panel_manager.h"
 
 class ElementManager {
 private:
     DrawElement *elements[MAX_ELEMENTS];
     size_t elementCount;
     uint8_t *framebuffer;
+    PanelManager &panel;
+    display_properties_t drawn_display; // The display mode the framebuffer content was drawn in
 
     struct ElementAction {
         DrawElement *element;
@@ -24,7 +28,7 @@ private:
     std::vector<ElementAction> action_queue;
 
 public:
-    ElementManager(uint8_t *fb) : framebuffer(fb), elementCount(0) {
+    ElementManager(PanelManager &panel) : framebuffer(panel.getFramebuffer()), elementCount(0), panel(panel), drawn_display(current_display) {
         memset(elements, 0, sizeof(elements));
     }
 
@@ -141,10 +145,25 @@ public:
     }
 
     void loop() {
-        if (action_queue.empty())
-            return;
+        // The display mode was switched (e.g. "toggle-dark"), recolor what is already drawn
+        if (drawn_display.background_color != current_display.background_color ||
+            drawn_display.foreground_color != current_display.foreground_color) {
+            applyDisplayMode();
+        }
 
-        bool action_performed = false;
+        // Touched elements show their pressed state for one update, then get restored
+        for (size_t i = 0; i < MAX_ELEMENTS; i++) {
+            if (!elements[i])
+                continue;
+            if (elements[i]->isShowingTouched()) {
+                elements[i]->restoreTouched(framebuffer);
+                elements[i]->setTouched(false);
+            } else if (elements[i]->isTouched()) {
+                elements[i]->showTouched(framebuffer);
+                if (!elements[i]->isShowingTouched())
+                    elements[i]->setTouched(false);
+            }
+        }
 
         // Process all queued actions
         while (!action_queue.empty()) {
@@ -157,17 +176,46 @@ public:
 
                 if (action.needs_draw) {
                     action.element->draw(framebuffer);
-                    action_performed = true;
                 }
             }
             action_queue.erase(action_queue.begin());
         }
-        if (action_performed && framebuffer != nullptr) {
-            draw_framebuffer(framebuffer);
+
+        // Draws and panel flashes record damage, only those areas are handed to the panel task
+        if (framebuffer != nullptr) {
+            panel.present();
         }
     }
 
 private:
+    /**
+     * @brief Switch the drawn page to the current display mode with one framebuffer remap and one refresh
+     */
+    void applyDisplayMode() {
+        LOG_I("Display mode changed, remapping framebuffer");
+        remap_display_mode(drawn_display, framebuffer);
+        drawn_display = current_display;
+
+        // Text rendered in the old colors is never drawn again, free it here on the task that draws text
+        epd_text_cache_clear();
+
+        for (size_t i = 0; i < MAX_ELEMENTS; i++) {
+            if (!elements[i])
+                continue;
+            elements[i]->applyDisplayMode();
+
+            // Album art must keep its colors, draw it again on the new background
+            if (elements[i]->getType() == ElementType::IMAGE &&
+                elements[i]->getImageType() == ImageType::SPOTIFY_ALBUM_ART) {
+                elements[i]->clearArea(framebuffer, true);
+                queueAction(elements[i], false, true, NO_REFRESH);
+            }
+        }
+
+        // Flash to the new background, the remapped framebuffer is drawn at the end of the loop
+        refresh_display(DISPLAY_REFRESH_PARTIAL, framebuffer);
+    }
+
     DrawElement *createElementFromType(const char *typeStr) {
         if (strcmp(typeStr, "text") == 0)
             return new TextElement();
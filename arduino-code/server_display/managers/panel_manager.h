@@ -0,0 +1,180 @@
+#ifndef PANEL_MANAGER_H
+#define PANEL_MANAGER_H
+
+#include "../config.h"
+#include "../utils/eink.h"
+#include "epd_damage.h"
+#include "epd_driver.h"
+#include "epd_tiles.h"
+#include <Arduino.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+/**
+ * @brief Front/back framebuffer pair. Elements compose into the back buffer while a panel task
+ * drives the display from the front buffer on the other core. present() hands over the damaged
+ * areas, and the tiles written without damage that differ, by copying only those rows to the front
+ * buffer.
+ */
+class PanelManager {
+private:
+    uint8_t *front;          // What the panel task draws from
+    uint8_t *back;           // What the elements draw into
+    DamageList_t pending;    // Areas copied to the front buffer but not drawn yet, guarded by the panel lock
+    TileMask_t written;      // Tiles of the back buffer written without recording damage, see markWritten()
+    SemaphoreHandle_t ready; // Given when there is something pending
+    TaskHandle_t panelTaskHandle;
+
+    static void panelTaskWrapper(void *parameter) {
+        PanelManager *manager = (PanelManager *)parameter;
+        manager->panelTask();
+    }
+
+    /**
+     * @brief Async task that runs queued flashes, then draws pending areas of the front buffer to the display
+     */
+    void panelTask() {
+        while (true) {
+            xSemaphoreTake(ready, portMAX_DELAY);
+
+            PanelLock lock;
+            run_queued_flashes();
+            DamageList_t areas = pending;
+            pending.count = 0;
+            draw_framebuffer_areas(front, areas);
+        }
+    }
+
+public:
+    PanelManager() : front(nullptr), back(nullptr), pending(), written(), ready(NULL), panelTaskHandle(NULL) {}
+
+    ~PanelManager() {
+        if (panelTaskHandle != NULL) {
+            vTaskDelete(panelTaskHandle);
+        }
+        if (ready != NULL) {
+            vSemaphoreDelete(ready);
+        }
+        heap_caps_free(front);
+        heap_caps_free(back);
+    }
+
+    /**
+     * @brief Allocate both framebuffers in PSRAM and start the panel task
+     * @return Whether the buffers could be allocated
+     */
+    bool begin() {
+        size_t size = EPD_WIDTH * EPD_HEIGHT / 2;
+        front = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        back = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if (!front || !back) {
+            LOG_E("Failed to allocate framebuffer memory");
+            return false;
+        }
+        memset(front, 0xFF, size);
+        memset(back, 0xFF, size);
+        LOG_D("Allocated front and back framebuffers of %d bytes each", size);
+
+        ready = xSemaphoreCreateBinary();
+
+        // The compose loop runs on core 1, drive the panel from core 0, the output tasks of each draw included
+        epd_set_output_core(0);
+        xTaskCreatePinnedToCore(
+            panelTaskWrapper, // Task function
+            "PanelTask",      // Task name
+            8192,             // Stack size (bytes)
+            this,             // Task parameters
+            2,                // Priority
+            &panelTaskHandle, // Task handle
+            0                 // Core
+        );
+        return true;
+    }
+
+    /**
+     * @brief The buffer to compose into
+     */
+    uint8_t *getFramebuffer() const { return back; }
+
+    /**
+     * @brief Note an area of the back buffer written without recording damage, e.g. by writing its bytes directly
+     *
+     * present() compares the tiles of the area to the front buffer and hands over those that differ.
+     */
+    void markWritten(Rect_t area) {
+        int32_t x0 = max(0, (int32_t)area.x) / EPD_TILE_SIZE;
+        int32_t x1 = (min((int32_t)EPD_WIDTH, area.x + area.width) + EPD_TILE_SIZE - 1) / EPD_TILE_SIZE;
+        int32_t y0 = max(0, (int32_t)area.y) / EPD_TILE_SIZE;
+        int32_t y1 = (min((int32_t)EPD_HEIGHT, area.y + area.height) + EPD_TILE_SIZE - 1) / EPD_TILE_SIZE;
+        for (int32_t ty = y0; ty < y1; ty++) {
+            for (int32_t tx = x0; tx < x1; tx++)
+                written[ty] |= 1u << tx;
+        }
+    }
+
+    /**
+     * @brief Find the tiles among `tiles` in which the back buffer differs from the front buffer
+     */
+    void findChangedTiles(const TileMask_t tiles, TileMask_t changed) const {
+        const size_t row_bytes = EPD_WIDTH / 2;
+        const size_t tile_bytes = EPD_TILE_SIZE / 2;
+        memset(changed, 0, sizeof(TileMask_t));
+        for (int32_t ty = 0; ty < EPD_TILES_Y; ty++) {
+            for (int32_t row = ty * EPD_TILE_SIZE; tiles[ty] != 0 && row < min((ty + 1) * EPD_TILE_SIZE, (int32_t)EPD_HEIGHT); row++) {
+                for (int32_t tx = 0; tx < EPD_TILES_X; tx++) {
+                    size_t offset = row * row_bytes + tx * tile_bytes;
+                    if ((tiles[ty] & ~changed[ty] & (1u << tx)) && memcmp(front + offset, back + offset, tile_bytes) != 0)
+                        changed[ty] |= 1u << tx;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Hand the areas damaged since the last call, and the tiles written without damage that changed, to the
+     * panel task
+     *
+     * Returns at once when nothing changed, or when the panel task is drawing: the damage is kept and handed over on a
+     * later call, so composing never waits for the panel.
+     */
+    void present() {
+        bool any_written = false;
+        for (int32_t ty = 0; ty < EPD_TILES_Y; ty++)
+            any_written |= written[ty] != 0;
+        if (epd_damage_empty() && !any_written && uxQueueMessagesWaiting(flash_queue) == 0)
+            return;
+
+        PanelLock lock(0);
+        if (!lock.isHeld())
+            return;
+
+        DamageList_t areas;
+        TileMask_t changed;
+        epd_damage_take(&areas);
+        findChangedTiles(written, changed);
+        memset(written, 0, sizeof(TileMask_t));
+        epd_tiles_add_damage(changed, &areas);
+        if (areas.count == 0) {
+            // Only flashes are waiting, they run before the panel task draws
+            if (uxQueueMessagesWaiting(flash_queue) > 0)
+                xSemaphoreGive(ready);
+            return;
+        }
+
+        for (int32_t i = 0; i < areas.count; i++) {
+            Rect_t area = areas.rects[i];
+            int32_t first = max(0, (int32_t)area.x) / 2;
+            int32_t last = (min((int32_t)EPD_WIDTH, area.x + area.width) + 1) / 2;
+            for (int32_t row = max(0, (int32_t)area.y); row < min((int32_t)EPD_HEIGHT, area.y + area.height) && first < last; row++) {
+                size_t offset = row * EPD_WIDTH / 2 + first;
+                memcpy(front + offset, back + offset, last - first);
+            }
+            epd_damage_list_add(&pending, area);
+        }
+        xSemaphoreGive(ready);
+    }
+};
+
+#endif // PANEL_MANAGER_H
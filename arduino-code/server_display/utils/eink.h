@@ -2,7 +2,12 @@
 #define UTILS_EINK_H
 
 #include "../config.h"
+#include "epd_damage.h"
 #include "epd_driver.h"
+#include "epd_planner.h"
+#include "epd_saveunder.h"
+#include "epd_swar.h"
+#include "epd_tiles.h"
 #include <Arduino.h>
 #include "types.h"
 
@@ -70,6 +75,26 @@ const display_properties_t BLACK_DISPLAY = {
 // Current display properties - initialize to white display
 display_properties_t current_display = WHITE_DISPLAY;
 
+// Serializes access to the panel (and the stored copy of what it shows) between the compose loop and the panel task
+SemaphoreHandle_t panel_mutex = xSemaphoreCreateRecursiveMutex();
+
+/**
+ * @brief Holds the panel for the lifetime of the object
+ * @param wait Ticks to wait for the panel, check isHeld() when not waiting forever
+ */
+class PanelLock {
+private:
+    bool held;
+
+public:
+    PanelLock(TickType_t wait = portMAX_DELAY) : held(xSemaphoreTakeRecursive(panel_mutex, wait) == pdTRUE) {}
+    ~PanelLock() {
+        if (held)
+            xSemaphoreGiveRecursive(panel_mutex);
+    }
+    bool isHeld() const { return held; }
+};
+
 /**
  * @brief Clear a specific area of the display using current background color in framebuffer
  */
@@ -78,37 +103,29 @@ void clear_framebuffer_area(Rect_t area, uint8_t *framebuffer) {
         return;
 
     LOG_D("Clearing area: %d, %d, %d, %d", area.x, area.y, area.width, area.height);
+    epd_damage_add(area);
 
     // Convert background color to 4-bit value (0-15)
     uint8_t fill_value = current_display.background_color & 0x0F;
 
-    for (int y = area.y; y < area.y + area.height; y++) {
-        for (int x = area.x; x < area.x + area.width; x++) {
-            if (x < 0 || x >= EPD_WIDTH || y < 0 || y >= EPD_HEIGHT)
-                continue;
-
-            int idx = (y * EPD_WIDTH + x) / 2;
-            if (x % 2 == 0) {
-                framebuffer[idx] = (framebuffer[idx] & 0x0F) | (fill_value << 4);
-            } else {
-                framebuffer[idx] = (framebuffer[idx] & 0xF0) | fill_value;
-            }
-        }
-    }
+    int32_t x0 = max(0, (int32_t)area.x);
+    int32_t x1 = min((int32_t)EPD_WIDTH, area.x + area.width);
+    int32_t y0 = max(0, (int32_t)area.y);
+    int32_t y1 = min((int32_t)EPD_HEIGHT, area.y + area.height);
+    for (int32_t y = y0; y < y1; y++)
+        epd_swar_fill(framebuffer + y * EPD_WIDTH / 2, x0, x1 - x0, fill_value);
 }
 
 /**
- * @brief Push pixels to a specific area of the display with a default 2 cycle refresh
+ * @brief Flash an area of the display to the background color, call with the panel held
  */
-void clear_area(Rect_t area, uint8_t *framebuffer, int32_t cycles = 2, int16_t bg_time = 50, int16_t fg_time = 50) {
-    if (!framebuffer)
-        return;
-
+void flash_area(Rect_t area, int32_t cycles = 2, int16_t bg_time = 50, int16_t fg_time = 50) {
     // NOTE: Ya wanna end on the background color
-
     int32_t bg_color = current_display.background_color == 0 ? 0 : 1;
     int32_t fg_color = bg_color == 0 ? 1 : 0;
 
+    epd_tiles_invalidate(area);
+
     for (int32_t c = 0; c < cycles; c++) {
         for (int32_t i = 0; i < 4; i++) {
             epd_push_pixels(area, fg_time, fg_color);
@@ -119,6 +136,64 @@ void clear_area(Rect_t area, uint8_t *framebuffer, int32_t cycles = 2, int16_t b
     }
 }
 
+// A flash the compose loop asked for, run by the panel task before it draws
+struct PanelFlash {
+    Rect_t area;
+    int32_t cycles; // Black and white cycles, 0 for a single push to the background color
+    int16_t bg_time;
+    int16_t fg_time;
+};
+
+// Flashes waiting for the panel task
+QueueHandle_t flash_queue = xQueueCreate(16, sizeof(PanelFlash));
+
+/**
+ * @brief Run a flash, call with the panel held
+ */
+void run_flash(const PanelFlash &flash) {
+    if (flash.cycles > 0) {
+        flash_area(flash.area, flash.cycles, flash.bg_time, flash.fg_time);
+        return;
+    }
+    int32_t bg_color = current_display.background_color == 0 ? 0 : 1;
+    epd_push_pixels(flash.area, flash.bg_time, bg_color);
+    epd_tiles_invalidate(flash.area);
+}
+
+/**
+ * @brief Run the flashes queued by queue_flash, call from the panel task with the panel held
+ */
+void run_queued_flashes() {
+    PanelFlash flash;
+    while (xQueueReceive(flash_queue, &flash, 0) == pdTRUE)
+        run_flash(flash);
+}
+
+/**
+ * @brief Have the panel task flash an area before it draws the next update, without waiting for it
+ */
+void queue_flash(Rect_t area, int32_t cycles, int16_t bg_time, int16_t fg_time) {
+    PanelFlash flash = {.area = area, .cycles = cycles, .bg_time = bg_time, .fg_time = fg_time};
+
+    // The flashed area no longer shows the framebuffer, draw it again on the next update
+    epd_damage_add(area);
+    if (xQueueSendToBack(flash_queue, &flash, 0) != pdTRUE) {
+        LOG_D("Flash queue full, flashing now");
+        PanelLock lock;
+        run_flash(flash);
+    }
+}
+
+/**
+ * @brief Push pixels to a specific area of the display with a default 2 cycle refresh
+ */
+void clear_area(Rect_t area, uint8_t *framebuffer, int32_t cycles = 2, int16_t bg_time = 50, int16_t fg_time = 50) {
+    if (!framebuffer)
+        return;
+
+    queue_flash(area, cycles, bg_time, fg_time);
+}
+
 /**
  * @brief Set the entire display background using current background color
  */
@@ -163,6 +238,49 @@ void set_custom_display_mode(display_properties_t new_display) {
     current_display = new_display;
 }
 
+/**
+ * @brief Invert the gray values of an area in the framebuffer, e.g. for a pressed state
+ */
+void invert_framebuffer_area(Rect_t area, uint8_t *framebuffer) {
+    if (!framebuffer)
+        return;
+
+    uint8_t palette[16];
+    for (uint8_t v = 0; v < 16; v++)
+        palette[v] = 15 - v;
+    epd_remap_palette_area(area, palette, framebuffer);
+}
+
+/**
+ * @brief Build the palette that recolors a framebuffer drawn in one display mode to another
+ */
+void get_display_mode_palette(const display_properties_t &from, const display_properties_t &to, uint8_t *palette) {
+    // Greys without a role (anti-aliased edges, images) flip along with the background
+    bool invert = (from.background_color > 7) != (to.background_color > 7);
+    for (uint8_t v = 0; v < 16; v++)
+        palette[v] = invert ? 15 - v : v;
+
+    // Colors with a role take the color of the same role in the new mode
+    palette[from.background_color & 0x0F] = to.background_color & 0x0F;
+    palette[from.foreground_color & 0x0F] = to.foreground_color & 0x0F;
+    palette[from.primary.fg_color & 0x0F] = to.primary.fg_color & 0x0F;
+    palette[from.secondary.fg_color & 0x0F] = to.secondary.fg_color & 0x0F;
+    palette[from.tertiary.fg_color & 0x0F] = to.tertiary.fg_color & 0x0F;
+    palette[from.quaternary.fg_color & 0x0F] = to.quaternary.fg_color & 0x0F;
+}
+
+/**
+ * @brief Recolor a framebuffer drawn in the previous display mode to the current one in place
+ */
+void remap_display_mode(const display_properties_t &previous, uint8_t *framebuffer) {
+    if (!framebuffer)
+        return;
+
+    uint8_t palette[16];
+    get_display_mode_palette(previous, current_display, palette);
+    epd_remap_palette(palette, framebuffer);
+}
+
 void refresh_display(RefreshType refresh_type, uint8_t *framebuffer) {
     if (refresh_type == NO_REFRESH || refresh_type == REFETCH_ELEMENTS)
         return;
@@ -181,10 +299,7 @@ void refresh_display(RefreshType refresh_type, uint8_t *framebuffer) {
         break;
     case DISPLAY_REFRESH_FAST:
         LOG_D("Display fast refresh");
-        if (!framebuffer)
-            return;
-        int32_t bg_color = current_display.background_color == 0 ? 0 : 1;
-        epd_push_pixels(full_screen, 50, bg_color);
+        queue_flash(full_screen, 0, 50, 50);
         break;
     }
 }
@@ -206,31 +321,94 @@ void refresh_area(RefreshType refresh_type, uint8_t *framebuffer, Rect_t area) {
         break;
     case ELEMENT_REFRESH_FAST:
         LOG_D("Element fast refresh");
-        if (!framebuffer)
-            return;
-        int32_t bg_color = current_display.background_color == 0 ? 0 : 1;
-        epd_push_pixels(area, 50, bg_color);
+        queue_flash(area, 0, 50, 50);
         break;
     }
 }
 
 /**
- * @brief Refresh the display by clearing and powering off (4 times)
+ * @brief Draw areas of the framebuffer to the epd, call after epd_tiles_find_changed with the panel held
  */
-void eink_full_refresh() {
+void draw_damaged_areas(uint8_t *framebuffer, const DamageList_t &areas) {
+    if (areas.count == 0)
+        return;
+
+    UpdatePlan_t plan;
+    epd_plan_update(&areas, 0, &plan);
+    LOG_D("Planned %d passes for %d areas, estimated %u us", plan.count, areas.count, plan.cost_us);
+
+    unsigned long start_time = micros();
+    epd_reset_update_stats();
     epd_poweron();
-    epd_clear();
+    for (int32_t i = 0; i < plan.count; i++) {
+        const PlannedPass_t &pass = plan.passes[i];
+        Rect_t area = pass.area;
+
+        // Rows identical to the displayed frame are left alone, skip the pass if none changed
+        if (pass.rows == 0)
+            continue;
+        uint8_t row_mask[(EPD_HEIGHT + 7) / 8];
+        epd_tiles_row_mask(area, row_mask);
+        unsigned long pass_time = micros();
+
+        // Drive the area straight from the framebuffer rows
+        epd_draw_image_strided(area, framebuffer + area.y * EPD_WIDTH / 2, area.x, EPD_WIDTH / 2,
+                               BLACK_ON_WHITE, row_mask);
+        LOG_D("Pass %d: %d, %d, %d, %d with %d rows, estimated %u us, took %lu us",
+              i, area.x, area.y, area.width, area.height, pass.rows, pass.cost_us, micros() - pass_time);
+    }
     epd_poweroff();
+
+    UpdateStats_t stats;
+    epd_get_update_stats(&stats);
+    LOG_D("Drew %d passes in %lu us: %u bytes converted, %u rows written, %u rows skipped (%u unchanged)",
+          plan.count, micros() - start_time, stats.bytes_converted, stats.rows_written, stats.rows_skipped, stats.rows_unchanged);
 }
 
 /**
- * @brief Draw the display by drawing the framebuffer to the epd
+ * @brief Flash the tiles that used up their ghosting budget and draw them again, call with the panel held
+ *
+ * Only worn tiles flash, the rest of the page stays as it is.
  */
-void draw_framebuffer(uint8_t *framebuffer) {
-    LOG_D("Drawing framebuffer");
-    epd_poweron();
-    epd_draw_grayscale_image(epd_full_screen(), framebuffer);
-    epd_poweroff();
+void flash_ghosted_tiles(uint8_t *framebuffer) {
+    TileMask_t ghosted;
+    int32_t ghosted_tiles = epd_tiles_find_ghosted(ghosted);
+    if (ghosted_tiles == 0)
+        return;
+    LOG_I("Flashing %d ghosted tiles", ghosted_tiles);
+
+    DamageList_t areas = {};
+    epd_tiles_add_damage(ghosted, &areas);
+    UpdatePlan_t plan;
+    epd_plan_update(&areas, 2, &plan);
+    LOG_D("Planned %d flashes, estimated %u us", plan.count, plan.cost_us);
+    unsigned long flash_time = micros();
+    for (int32_t i = 0; i < plan.count; i++)
+        flash_area(plan.passes[i].area, 2);
+    LOG_D("Flashed in %lu us", micros() - flash_time);
+
+    // Flashed tiles are no longer known and show up as changed
+    TileMask_t changed;
+    areas.count = 0;
+    epd_tiles_find_changed(framebuffer, changed);
+    epd_tiles_add_damage(changed, &areas);
+    draw_damaged_areas(framebuffer, areas);
+    epd_tiles_commit(framebuffer);
+}
+
+/**
+ * @brief Draw given areas of the framebuffer plus the tiles that differ from the displayed frame
+ *
+ * The tiles make changes that were never reported show up as well. Only the panel task draws, see PanelManager.
+ */
+void draw_framebuffer_areas(uint8_t *framebuffer, DamageList_t &areas) {
+    PanelLock lock;
+    TileMask_t changed;
+    epd_tiles_find_changed(framebuffer, changed);
+    epd_tiles_add_damage(changed, &areas);
+    draw_damaged_areas(framebuffer, areas);
+    epd_tiles_commit(framebuffer);
+    flash_ghosted_tiles(framebuffer);
 }
 
 #endif // UTILS_EINK_H
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef UTILS_FONTS_H
+#define UTILS_FONTS_H
+
+#include "../config.h"
+#include "epd_driver.h"
+#include "epd_font_file.h"
+#include "epd_glyph_cache.h"
+#include "firasans.h"
+#include <Arduino.h>
+
+#ifndef FONT_SD_PATH
+#define FONT_SD_PATH "/sd/fonts" // fopen path, the SD library mounts the card at /sd
+#endif
+
+// A font elements can select, compiled in or loaded from the SD card the first time it is drawn
+struct RegisteredFont {
+    const char *name;       // The name elements select the font by, e.g. "large"
+    const GFXfont *builtin; // The compiled in font, nullptr to load file
+    const char *file;       // The font file in FONT_SD_PATH, written by fontconvert.py --binary
+    GFXfont loaded;         // The font once loaded from file
+    bool is_loaded;
+    bool load_failed; // Don't retry a missing or broken file on every draw
+};
+
+// scripts/make_sd_fonts.sh writes the font files
+RegisteredFont registered_fonts[] = {
+    {"regular", &FiraSans, nullptr},
+    {"large", nullptr, "FiraSans-24.bin"},
+    {"huge", nullptr, "FiraSans-48.bin"},
+};
+
+const uint8_t FONT_COUNT = sizeof(registered_fonts) / sizeof(registered_fonts[0]);
+const uint8_t DEFAULT_FONT = 0;
+
+// The font of each text level (1 to 4) for elements that name none
+const uint8_t LEVEL_FONTS[] = {DEFAULT_FONT, DEFAULT_FONT, DEFAULT_FONT, DEFAULT_FONT};
+
+/**
+ * @brief Find the font an element draws with
+ * @param name The font name from the element JSON, empty to use the level font
+ * @param level The text level of the element
+ * @return The registry index of the font
+ */
+uint8_t find_font(const char *name, uint8_t level) {
+    for (uint8_t i = 0; i < FONT_COUNT; i++) {
+        if (strcmp(registered_fonts[i].name, name) == 0)
+            return i;
+    }
+    if (strlen(name) > 0)
+        LOG_E("Unknown font %s", name);
+    if (level >= 1 && level <= sizeof(LEVEL_FONTS))
+        return LEVEL_FONTS[level - 1];
+    return DEFAULT_FONT;
+}
+
+/**
+ * @brief Get the RAM a font uses: the index of a loaded font and its cached glyphs
+ */
+size_t get_font_memory(uint8_t id) {
+    RegisteredFont &font = registered_fonts[id];
+    const GFXfont *gfx = font.builtin ? font.builtin : &font.loaded;
+    if (!font.builtin && !font.is_loaded)
+        return 0;
+    return epd_font_memory(gfx) + epd_glyph_cache_font_bytes(gfx);
+}
+
+void log_font_memory() {
+    for (uint8_t i = 0; i < FONT_COUNT; i++) {
+        const char *state = registered_fonts[i].builtin ? "built in" : registered_fonts[i].is_loaded ? "loaded"
+                                                                                                    : "not loaded";
+        LOG_D("Font %s (%s): %u bytes", registered_fonts[i].name, state, get_font_memory(i));
+    }
+}
+
+/**
+ * @brief Get a font, loading it from the SD card on first use
+ * Falls back to the default font if the file can't be loaded
+ */
+const GFXfont *get_font(uint8_t id) {
+    if (id >= FONT_COUNT)
+        id = DEFAULT_FONT;
+    RegisteredFont &font = registered_fonts[id];
+    if (font.builtin)
+        return font.builtin;
+
+    if (!font.is_loaded && !font.load_failed) {
+        char path[64];
+        snprintf(path, sizeof(path), "%s/%s", FONT_SD_PATH, font.file);
+        font.is_loaded = epd_font_load(path, &font.loaded);
+        font.load_failed = !font.is_loaded;
+        if (font.is_loaded) {
+            LOG_I("Loaded font %s from %s", font.name, path);
+            log_font_memory();
+        } else {
+            LOG_E("Failed to load font %s from %s", font.name, path);
+        }
+    }
+    return font.is_loaded ? &font.loaded : registered_fonts[DEFAULT_FONT].builtin;
+}
+
+#endif // UTILS_FONTS_H
@@ -2,6 +2,7 @@
 #define UTILS_STORAGE_H
 
 #include "../config.h"
+#include "epd_swar.h"
 #include "utilities.h"
 #include <Arduino.h>
 #include <FS.h>
@@ -10,6 +11,8 @@
 
 bool cardMounted = false;
 
+int convertCachedImages(const char *dirname);
+
 void setupSD() {
     SPI.begin(SD_SCLK, SD_MISO, SD_MOSI, SD_CS);
     if (!SD.begin(SD_CS, SPI, 4000000)) {
@@ -20,6 +23,10 @@ void setupSD() {
     LOG_I("Card mounted");
     LOG_D("Card size: %lluMB", SD.cardSize() / (1024 * 1024));
     cardMounted = true;
+
+    int converted = convertCachedImages(IMAGE_SD_PATH);
+    if (converted > 0)
+        LOG_I("Converted %d cached images to the current format", converted);
 }
 
 bool isCardMounted() {
@@ -255,18 +262,66 @@ void testSD() {
 }
 #pragma endregion
 
+#pragma region Cached Images
+/**
+ * Cached images start with an ImageFileHeader. Files without the magic are from before the header was
+ * added: width and height followed by pixel data with the left pixel in the high nibble.
+ */
+#define IMAGE_FILE_MAGIC 0x49445045 // "EPDI"
+#define IMAGE_FILE_VERSION 1
+
+enum ImageFileFlags : uint16_t {
+    IMAGE_NATIVE_ORDER = 1 << 0, // Left pixel in the low nibble, as in the framebuffer
+    // 1 << 1 marked opaque images in older files and is ignored, the element decides when it draws
+};
+
+struct ImageFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags; // ImageFileFlags
+    uint32_t width;
+    uint32_t height;
+};
+
+/**
+ * @brief Write a header and pixel data to a file, replacing it
+ */
+bool writeImageFile(const String &file_path, const ImageFileHeader &header, const uint8_t *data, size_t size) {
+    File file = SD.open(file_path, FILE_WRITE);
+    if (!file) {
+        LOG_E("Failed to open file for writing");
+        return false;
+    }
+
+    if (file.write((const uint8_t *)&header, sizeof(header)) != sizeof(header)) {
+        LOG_E("Failed to write image header");
+        file.close();
+        return false;
+    }
+
+    if (file.write(data, size) != size) {
+        LOG_E("Failed to write image data");
+        file.close();
+        return false;
+    }
+
+    file.close();
+    return true;
+}
+
 /**
  * Saves a 4-bit grayscale image to the SD card with the following format:
- * - Header: 8 bytes (4 bytes width + 4 bytes height)
+ * - Header: ImageFileHeader (magic, version, flags, width, height)
  * - Data: Raw 4-bit grayscale pixel data (packed 2 pixels per byte)
  *
  * @param filename Path relative to IMAGE_SD_PATH (e.g., "icons/weather/sun.bin")
  * @param img_buffer Raw 4-bit grayscale image data (2 pixels per byte)
  * @param width Image width in pixels
  * @param height Image height in pixels
+ * @param flags ImageFileFlags describing the data
  * @return true if save successful, false otherwise
  */
-bool saveImageBufferToSD(String filename, uint8_t *img_buffer, uint32_t width, uint32_t height) {
+bool saveImageBufferToSD(String filename, uint8_t *img_buffer, uint32_t width, uint32_t height, uint16_t flags) {
     if (!cardMounted)
         return false;
 
@@ -290,53 +345,30 @@ bool saveImageBufferToSD(String filename, uint8_t *img_buffer, uint32_t width, u
         }
     }
 
-    String file_path = String(IMAGE_SD_PATH) + String("/") + filename;
-    File file = SD.open(file_path, FILE_WRITE);
-
-    if (!file) {
-        LOG_E("Failed to open file for writing");
-        return false;
-    }
-
+    ImageFileHeader header = {
+        .magic = IMAGE_FILE_MAGIC,
+        .version = IMAGE_FILE_VERSION,
+        .flags = flags,
+        .width = width,
+        .height = height};
     size_t bytes_per_row = width / 2;
-    size_t image_data_size = bytes_per_row * height;
-
-    // Write dimensions
-    if (file.write((uint8_t *)&width, 4) != 4) {
-        LOG_E("Failed to write width");
-        file.close();
-        return false;
-    }
-
-    if (file.write((uint8_t *)&height, 4) != 4) {
-        LOG_E("Failed to write height");
-        file.close();
-        return false;
-    }
-
-    // Write image data
-    if (file.write(img_buffer, image_data_size) != image_data_size) {
-        LOG_E("Failed to write image data");
-        file.close();
-        return false;
-    }
-
-    file.close();
-    return true;
+    return writeImageFile(String(IMAGE_SD_PATH) + String("/") + filename, header, img_buffer, bytes_per_row * height);
 }
 
 /**
- * Reads a 4-bit grayscale image from the SD card with the following format:
- * - Header: 8 bytes (4 bytes width + 4 bytes height)
- * - Data: Raw 4-bit grayscale pixel data (packed 2 pixels per byte)
+ * Reads a 4-bit grayscale image from the SD card, see saveImageBufferToSD for the format.
+ * Files without a header are read as well. The data is always returned with the left pixel in the
+ * low nibble, flags has IMAGE_NATIVE_ORDER set.
  *
  * @param filename Path relative to IMAGE_SD_PATH (e.g., "icons/weather/sun.bin")
  * @param img_buffer Raw 4-bit grayscale image data (2 pixels per byte)
+ * @param capacity Size of img_buffer in bytes
  * @param width Image width in pixels
  * @param height Image height in pixels
+ * @param flags ImageFileFlags of the image
  * @return true if read successful, false otherwise
  */
-bool readImageBufferFromSD(String filename, uint8_t *img_buffer, uint32_t &width, uint32_t &height) {
+bool readImageBufferFromSD(String filename, uint8_t *img_buffer, size_t capacity, uint32_t &width, uint32_t &height, uint16_t &flags) {
     String file_path = String(IMAGE_SD_PATH) + String("/") + filename;
     if (!SD.exists(file_path)) {
         return false;
@@ -348,25 +380,124 @@ bool readImageBufferFromSD(String filename, uint8_t *img_buffer, uint32_t &width
         return false;
     }
 
-    // Read dimensions
-    if (file.read((uint8_t *)&width, 4) != 4 ||
-        file.read((uint8_t *)&height, 4) != 4) {
+    // Read the header, files from before the header start with the width
+    ImageFileHeader header;
+    if (file.read((uint8_t *)&header.magic, 4) != 4) {
         file.close();
-        LOG_E("Failed to read image dimensions");
+        LOG_E("Failed to read image header");
         return false;
     }
+    if (header.magic == IMAGE_FILE_MAGIC) {
+        size_t rest = sizeof(header) - 4;
+        if (file.read((uint8_t *)&header + 4, rest) != rest) {
+            file.close();
+            LOG_E("Failed to read image header");
+            return false;
+        }
+        if (header.version > IMAGE_FILE_VERSION) {
+            file.close();
+            LOG_E("Unsupported image version %d", header.version);
+            return false;
+        }
+    } else {
+        header.width = header.magic;
+        header.flags = 0;
+        if (file.read((uint8_t *)&header.height, 4) != 4) {
+            file.close();
+            LOG_E("Failed to read image dimensions");
+            return false;
+        }
+    }
+    width = header.width;
+    height = header.height;
+    flags = header.flags;
 
     // Read image data
     size_t bytes_per_row = width / 2;
     size_t image_data_size = bytes_per_row * height;
+    if (image_data_size > capacity) {
+        file.close();
+        LOG_E("Image of %dx%d does not fit the buffer", width, height);
+        return false;
+    }
     if (file.read(img_buffer, image_data_size) != image_data_size) {
         file.close();
         LOG_E("Failed to read image data");
         return false;
     }
-
     file.close();
+
+    if (!(flags & IMAGE_NATIVE_ORDER)) {
+        epd_swar_swap_buffer(img_buffer, image_data_size);
+        flags |= IMAGE_NATIVE_ORDER;
+    }
     return true;
 }
 
+/**
+ * @brief Rewrite cached images from before the header in the current format, once per file
+ * @param dirname Directory to convert, subdirectories included
+ * @return Number of converted files
+ */
+int convertCachedImages(const char *dirname) {
+    if (!cardMounted)
+        return 0;
+
+    File dir = SD.open(dirname);
+    if (!dir || !dir.isDirectory())
+        return 0;
+
+    int converted = 0;
+    File file = dir.openNextFile();
+    while (file) {
+        String path = file.path();
+        if (file.isDirectory()) {
+            file.close();
+            converted += convertCachedImages(path.c_str());
+            file = dir.openNextFile();
+            continue;
+        }
+
+        uint32_t magic = 0;
+        size_t size = file.size();
+        if (!path.endsWith(".bin") || size < 8 || file.read((uint8_t *)&magic, 4) != 4 || magic == IMAGE_FILE_MAGIC) {
+            file.close();
+            file = dir.openNextFile();
+            continue;
+        }
+
+        ImageFileHeader header = {
+            .magic = IMAGE_FILE_MAGIC,
+            .version = IMAGE_FILE_VERSION,
+            .flags = IMAGE_NATIVE_ORDER,
+            .width = magic,
+            .height = 0};
+        size_t data_size = size - 8;
+        uint8_t *data = (uint8_t *)ps_malloc(data_size);
+        bool ok = data != nullptr &&
+                  file.read((uint8_t *)&header.height, 4) == 4 &&
+                  file.read(data, data_size) == data_size;
+        file.close();
+
+        // Write next to the original and swap them, a failed write keeps the old file
+        if (ok) {
+            epd_swar_swap_buffer(data, data_size);
+            String temp_path = path + ".tmp";
+            ok = writeImageFile(temp_path, header, data, data_size) &&
+                 SD.remove(path) && SD.rename(temp_path, path);
+        }
+        free(data);
+
+        if (ok) {
+            converted++;
+        } else {
+            LOG_E("Failed to convert cached image %s", path.c_str());
+        }
+        file = dir.openNextFile();
+    }
+    dir.close();
+    return converted;
+}
+#pragma endregion
+
 #endif // UTILS_STORAGE_H
\ No newline at end of file
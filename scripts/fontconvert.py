@@ -5,19 +5,25 @@ import sys
 import re
 import math
 import argparse
+import struct
 from collections import namedtuple
 
 parser = argparse.ArgumentParser(description="Generate a header file from a font to be used with epdiy.")
 parser.add_argument("name", action="store", help="name of the font.")
 parser.add_argument("size", type=int, help="font size to use.")
 parser.add_argument("fontstack", action="store", nargs='+', help="list of font files, ordered by descending priority.")
-parser.add_argument("--compress", dest="compress", action="store_true", help="compress glyph bitmaps.")
+parser.add_argument("--compress", dest="compress", action="store_true", help="compress glyph bitmaps with zlib, same as --codec zlib.")
+parser.add_argument("--codec", dest="codec", choices=["none", "zlib", "rle", "deflate"], help="glyph bitmap compression, none by default. rle is larger than zlib but decodes faster, deflate is zlib without header and checksum.")
+parser.add_argument("--binary", dest="binary", action="store_true", help="write a font file for epd_font_load instead of a header.")
 args = parser.parse_args()
+if args.compress and args.codec not in (None, "zlib"):
+    parser.error(f"--compress means --codec zlib, it can't be combined with --codec {args.codec}")
 
 GlyphProps = namedtuple("GlyphProps", ["width", "height", "advance_x", "left", "top", "compressed_size", "data_offset", "code_point"])
 
 font_stack = [freetype.Face(f) for f in args.fontstack]
-compress = args.compress
+# values of enum GlyphCodec in epd_driver.h
+codec = {"none": 0, "zlib": 1, "rle": 2, "deflate": 3}[args.codec or ("zlib" if args.compress else "none")]
 size = args.size
 font_name = args.name
 
@@ -46,6 +52,34 @@ for face in font_stack:
     # the display has about 150 dpi.
     face.set_char_size(size << 6, size << 6, 150, 150)
 
+def rle_compress(packed):
+    """Encode a bitmap as GLYPH_CODEC_RLE, decoded by rle_decode in src/epd_glyph_cache.c."""
+    pixels = []
+    for b in packed:
+        pixels += [b & 0xF, b >> 4]
+    # blank and full pixels are worth a run from two on
+    def starts_run(i):
+        return pixels[i] in (0x0, 0xF) and (i + 1 == len(pixels) or pixels[i + 1] == pixels[i])
+    nibbles = []
+    i = 0
+    while i < len(pixels):
+        value = 0
+        run = 0
+        if pixels[i] in (0x0, 0xF):
+            value = pixels[i]
+            while i < len(pixels) and pixels[i] == value and run < 31:
+                run += 1
+                i += 1
+        literals = []
+        while i < len(pixels) and len(literals) < 3 and not starts_run(i):
+            literals.append(pixels[i])
+            i += 1
+        token = (0x80 if value == 0xF else 0) | run << 2 | len(literals)
+        nibbles += [token & 0xF, token >> 4] + literals
+    if len(nibbles) % 2:
+        nibbles.append(0)
+    return bytes(nibbles[i] | nibbles[i + 1] << 4 for i in range(0, len(nibbles), 2))
+
 def chunks(l, n):
     for i in range(0, len(l), n):
         yield l[i:i + n]
@@ -90,8 +124,13 @@ for i_start, i_end in intervals:
         packed = bytes(pixels);
         total_packed += len(packed)
         compressed = packed
-        if compress:
+        if codec == 1:
             compressed = zlib.compress(packed)
+        elif codec == 2:
+            compressed = rle_compress(packed)
+        elif codec == 3:
+            deflate = zlib.compressobj(wbits=-15)
+            compressed = deflate.compress(packed) + deflate.flush()
 
         glyph = GlyphProps(
             width = bitmap.width,
@@ -119,6 +158,25 @@ for index, glyph in enumerate(all_glyphs):
 print("total", total_packed, file=sys.stderr)
 print("compressed", total_size, file=sys.stderr)
 
+if args.binary:
+    # layout documented in src/epd_font_file.h
+    out = bytearray()
+    flags = {0: 0, 1: 1 << 0, 2: 1 << 1, 3: 1 << 2}[codec]
+    out += struct.pack("<IHHIIIiii", 0x46445045, 1, flags,
+                       len(intervals), len(glyph_props), len(glyph_data),
+                       norm_ceil(face.size.height), norm_ceil(face.size.ascender),
+                       norm_floor(face.size.descender))
+    offset = 0
+    for i_start, i_end in intervals:
+        out += struct.pack("<III", i_start, i_end, offset)
+        offset += i_end - i_start + 1
+    for g in glyph_props:
+        out += struct.pack("<BBBxhhHxxI", g.width, g.height, g.advance_x, g.left, g.top,
+                           g.compressed_size, g.data_offset)
+    out += bytes(glyph_data)
+    sys.stdout.buffer.write(out)
+    sys.exit(0)
+
 print("#pragma once")
 print("#include \"epd_driver.h\"")
 print(f"const uint8_t {font_name}Bitmaps[{len(glyph_data)}] = {{")
@@ -138,13 +196,31 @@ for i_start, i_end in intervals:
     offset += i_end - i_start + 1
 print ("};");
 
+# code points below this are looked up in a table instead of the intervals
+direct_count = 256
+print(f"const uint16_t {font_name}DirectIndex[{direct_count}] = {{")
+direct_index = []
+for code_point in range(direct_count):
+    index = 0xFFFF
+    offset = 0
+    for i_start, i_end in intervals:
+        if i_start <= code_point <= i_end:
+            index = offset + code_point - i_start
+        offset += i_end - i_start + 1
+    direct_index.append(index)
+for c in chunks(direct_index, 16):
+    print ("    " + " ".join(f"0x{i:04X}," for i in c))
+print ("};");
+
 print(f"const GFXfont {font_name} = {{")
 print(f"    (uint8_t*){font_name}Bitmaps,")
 print(f"    (GFXglyph*){font_name}Glyphs,")
 print(f"    (UnicodeInterval*){font_name}Intervals,")
 print(f"    {len(intervals)},")
-print(f"    {1 if compress else 0},")
+print(f"    {codec},")
 print(f"    {norm_ceil(face.size.height)},")
 print(f"    {norm_ceil(face.size.ascender)},")
 print(f"    {norm_floor(face.size.descender)},")
+print(f"    {font_name}DirectIndex,")
+print(f"    {direct_count},")
 print("};")
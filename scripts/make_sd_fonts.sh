@@ -0,0 +1,25 @@
+#!/bin/sh
+# Write the font files the display loads from the SD card, see registered_fonts
+# in arduino-code/server_display/utils/fonts.h. Copy them to the fonts folder of
+# the card: /fonts for the default FONT_SD_PATH of /sd/fonts.
+#
+#   scripts/make_sd_fonts.sh FiraSans-Regular.ttf [out_dir]
+#
+# Needs python3 with freetype-py, like fontconvert.py.
+
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 FiraSans-Regular.ttf [out_dir]" >&2
+    exit 1
+fi
+
+ttf=$1
+out=${2:-fonts}
+script_dir=$(dirname "$0")
+
+mkdir -p "$out"
+for size in 24 48; do
+    python3 "$script_dir/fontconvert.py" FiraSans "$size" "$ttf" --codec deflate --binary > "$out/FiraSans-$size.bin"
+    echo "wrote $out/FiraSans-$size.bin"
+done
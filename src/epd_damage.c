@@ -0,0 +1,207 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_damage.h"
+
+#include <string.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local function prototypes                                       ***/
+/******************************************************************************/
+
+/**
+ * @brief Clip an area to the screen and widen it to whole framebuffer bytes.
+ *
+ * @return false if nothing of the area is on screen.
+ */
+static bool clip_to_screen(Rect_t *area);
+
+static Rect_t rect_union(Rect_t a, Rect_t b);
+
+static inline int32_t rect_area(Rect_t r)
+{
+    return r.width * r.height;
+}
+
+static void remove_rect(DamageList_t *list, int32_t index);
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+/**
+ * @brief Damage recorded by the drawing functions.
+ */
+static DamageList_t damage;
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+void epd_damage_add(Rect_t area)
+{
+    epd_damage_list_add(&damage, area);
+}
+
+
+void epd_damage_list_add(DamageList_t *list, Rect_t area)
+{
+    if (!clip_to_screen(&area))
+    {
+        return;
+    }
+
+    for (int32_t i = 0; i < list->count; i++)
+    {
+        Rect_t r = list->rects[i];
+        if (area.x >= r.x && area.y >= r.y &&
+            area.x + area.width <= r.x + r.width &&
+            area.y + area.height <= r.y + r.height)
+        {
+            return;
+        }
+    }
+
+    // Absorb every rectangle whose union with the new area costs no more
+    // than drawing both separately. A grown area may reach new neighbours,
+    // so repeat until nothing merges.
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (int32_t i = 0; i < list->count; i++)
+        {
+            Rect_t u = rect_union(area, list->rects[i]);
+            if (rect_area(u) <= rect_area(area) + rect_area(list->rects[i]))
+            {
+                area = u;
+                remove_rect(list, i);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    // Out of slots: merge with the rectangle that adds the least extra area.
+    while (list->count >= EPD_DAMAGE_MAX_RECTS)
+    {
+        int32_t best = 0;
+        int32_t best_waste = INT32_MAX;
+        for (int32_t i = 0; i < list->count; i++)
+        {
+            Rect_t u = rect_union(area, list->rects[i]);
+            int32_t waste = rect_area(u) - rect_area(area) - rect_area(list->rects[i]);
+            if (waste < best_waste)
+            {
+                best_waste = waste;
+                best = i;
+            }
+        }
+        area = rect_union(area, list->rects[best]);
+        remove_rect(list, best);
+    }
+
+    list->rects[list->count++] = area;
+}
+
+
+int32_t epd_damage_get(Rect_t *rects, int32_t max_rects)
+{
+    int32_t count = damage.count < max_rects ? damage.count : max_rects;
+    memcpy(rects, damage.rects, count * sizeof(Rect_t));
+    return count;
+}
+
+
+Rect_t epd_damage_bounds()
+{
+    Rect_t bounds = {.x = 0, .y = 0, .width = 0, .height = 0};
+    for (int32_t i = 0; i < damage.count; i++)
+    {
+        bounds = i == 0 ? damage.rects[0] : rect_union(bounds, damage.rects[i]);
+    }
+    return bounds;
+}
+
+
+bool epd_damage_empty()
+{
+    return damage.count == 0;
+}
+
+
+void epd_damage_reset()
+{
+    damage.count = 0;
+}
+
+
+void epd_damage_take(DamageList_t *list)
+{
+    *list = damage;
+    damage.count = 0;
+}
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+static bool clip_to_screen(Rect_t *area)
+{
+    int32_t x0 = area->x < 0 ? 0 : area->x;
+    int32_t y0 = area->y < 0 ? 0 : area->y;
+    int32_t x1 = area->x + area->width;
+    int32_t y1 = area->y + area->height;
+    if (x1 > EPD_WIDTH)
+        x1 = EPD_WIDTH;
+    if (y1 > EPD_HEIGHT)
+        y1 = EPD_HEIGHT;
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return false;
+    }
+
+    // two pixels share a byte, round out to byte boundaries
+    x0 &= ~1;
+    x1 = (x1 + 1) & ~1;
+
+    area->x = x0;
+    area->y = y0;
+    area->width = x1 - x0;
+    area->height = y1 - y0;
+    return true;
+}
+
+
+static Rect_t rect_union(Rect_t a, Rect_t b)
+{
+    int32_t x0 = a.x < b.x ? a.x : b.x;
+    int32_t y0 = a.y < b.y ? a.y : b.y;
+    int32_t x1 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+    int32_t y1 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+    Rect_t u = {.x = x0, .y = y0, .width = x1 - x0, .height = y1 - y0};
+    return u;
+}
+
+
+static void remove_rect(DamageList_t *list, int32_t index)
+{
+    list->rects[index] = list->rects[--list->count];
+}
+
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -0,0 +1,106 @@
+/**
+ * Tracking of framebuffer areas changed since the last display update.
+ */
+
+#ifndef _EPD_DAMAGE_H_
+#define _EPD_DAMAGE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_driver.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief Maximum number of separate damaged rectangles kept by the tracker.
+ *        Further damage is merged into the closest existing rectangle.
+ */
+#define EPD_DAMAGE_MAX_RECTS 8
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/**
+ * @brief A set of damaged rectangles. Zero-initialize before use.
+ */
+typedef struct
+{
+    Rect_t rects[EPD_DAMAGE_MAX_RECTS];
+    int32_t count;
+} DamageList_t;
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/**
+ * @brief Mark an area of the framebuffer as changed.
+ *
+ * @note The area is clipped to the screen and widened to whole framebuffer
+ *       bytes (even x and width). Overlapping or touching rectangles are
+ *       merged, at most `EPD_DAMAGE_MAX_RECTS` rectangles are kept.
+ *
+ * @param area The changed area.
+ */
+void epd_damage_add(Rect_t area);
+
+/**
+ * @brief Add an area to a damage list other than the global one, merging the
+ *        same way as `epd_damage_add`.
+ */
+void epd_damage_list_add(DamageList_t *list, Rect_t area);
+
+/**
+ * @brief Copy the currently damaged rectangles.
+ *
+ * @param rects     Output array.
+ * @param max_rects Capacity of `rects`.
+ *
+ * @return The number of rectangles written.
+ */
+int32_t epd_damage_get(Rect_t *rects, int32_t max_rects);
+
+/**
+ * @brief Get the bounding box of all damaged rectangles.
+ */
+Rect_t epd_damage_bounds();
+
+/**
+ * @brief Check whether anything changed since the last reset.
+ */
+bool epd_damage_empty();
+
+/**
+ * @brief Forget all damage, e.g. after the framebuffer was pushed to the display.
+ */
+void epd_damage_reset();
+
+/**
+ * @brief Move the global damage into a list, leaving the global damage empty.
+ */
+void epd_damage_take(DamageList_t *list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -3,6 +3,8 @@
 /******************************************************************************/
 
 #include "epd_driver.h"
+#include "epd_damage.h"
+#include "epd_swar.h"
 #include "ed047tc1.h"
 
 #include <freertos/FreeRTOS.h>
@@ -16,6 +18,7 @@
 #include <esp_types.h>
 #include <xtensa/core-macros.h>
 
+#include <stdlib.h>
 #include <string.h>
 
 /******************************************************************************/
@@ -45,13 +48,32 @@
 
 typedef struct
 {
-    uint8_t *data_ptr;
+    const uint8_t *data_ptr;
+    int32_t src_x;  /** Pixel column of the area's left edge in the source rows. */
+    int32_t stride; /** Bytes between source rows. */
     SemaphoreHandle_t done_smphr;
     Rect_t area;
     int32_t frame;
     DrawMode_t mode;
+    const uint8_t *row_mask;
 } OutputParams;
 
+/**
+ * @brief A non-horizontal polygon edge in the scanline edge table.
+ *
+ * Vertical positions are given in (sub-)scanlines, horizontal positions in
+ * 16.16 fixed point pixels.
+ */
+typedef struct
+{
+    int32_t y_top;    /** First scanline crossed by the edge. */
+    int32_t y_bottom; /** First scanline below the edge. */
+    int32_t x_top;    /** Horizontal position of the upper vertex. */
+    int32_t x;        /** Horizontal position at the current scanline center. */
+    int32_t dx;       /** Horizontal increment per scanline. */
+    int32_t winding;  /** 1 for downward, -1 for upward edges. */
+} PolygonEdge;
+
 /******************************************************************************/
 /***        local function prototypes                                       ***/
 /******************************************************************************/
@@ -61,6 +83,14 @@ typedef struct
  */
 static void reorder_line_buffer(uint32_t *line_data);
 
+/**
+ * @brief Check whether row `row` of the area is selected by a row mask.
+ */
+static inline bool row_selected(const uint8_t *row_mask, int32_t row)
+{
+    return row_mask == NULL || (row_mask[row / 8] & (1 << (row % 8)));
+}
+
 /**
  * @brief output a row to the display.
  */
@@ -75,20 +105,59 @@ static void IRAM_ATTR reset_lut(uint8_t *lut_mem, DrawMode_t mode);
 
 static void IRAM_ATTR update_LUT(uint8_t *lut_mem, uint8_t k, DrawMode_t mode);
 
+static void IRAM_ATTR provide_out(OutputParams *params);
+
+static void IRAM_ATTR feed_display(OutputParams *params);
+
 /**
- * @brief bit-shift a buffer `shift` <= 7 bits to the right.
+ * @brief Set a single framebuffer pixel without recording damage.
  */
-static void IRAM_ATTR bit_shift_buffer_right(uint8_t *buf, uint32_t len, int32_t shift);
-
-static void IRAM_ATTR nibble_shift_buffer_right(uint8_t *buf, uint32_t len);
+static void set_pixel(int32_t x, int32_t y, uint8_t color, uint8_t *framebuffer);
 
-static void IRAM_ATTR provide_out(OutputParams *params);
+/**
+ * @brief Draw a horizontal line without recording damage.
+ */
+static void fill_hline(int32_t x, int32_t y, int32_t length, uint8_t color, uint8_t *framebuffer);
 
-static void IRAM_ATTR feed_display(OutputParams *params);
+/**
+ * @brief Draw a vertical line without recording damage.
+ */
+static void fill_vline(int32_t x, int32_t y, int32_t length, uint8_t color, uint8_t *framebuffer);
 
 static void epd_fill_circle_helper(int32_t x0, int32_t y0, int32_t r, int32_t corners, int32_t delta,
                             uint8_t color, uint8_t *framebuffer);
 
+/**
+ * @brief Scanline fill a polygon with `1 << shift` samples per pixel row.
+ */
+static void fill_polygon(const Point_t *points, int32_t count, FillRule_t rule,
+                         uint8_t color, uint8_t *framebuffer, int32_t shift);
+
+/**
+ * @brief Write a row of coverage counts to the framebuffer and reset them.
+ */
+static void flush_coverage(uint8_t *coverage, int32_t x_min, int32_t x_max, int32_t y,
+                           int32_t full, uint8_t color, uint8_t *framebuffer);
+
+/**
+ * @brief Build a LUT mapping both pixels of a framebuffer byte through a palette.
+ */
+static void build_palette_lut(const uint8_t *palette, uint8_t *lut);
+
+/**
+ * @brief Gather `len` bytes of image nibbles starting at nibble `start`, which
+ *        may be odd or -1, so they line up with the framebuffer bytes.
+ */
+static void build_blit_line(const uint8_t *src, int32_t src_len, int32_t start, int32_t len,
+                            bool swap, uint8_t *line);
+
+/**
+ * @brief Write `count` nibbles of a line to framebuffer bytes, the first one
+ *        into the high nibble of `dst[0]` if `first_high` is set.
+ */
+static void blit_line(const uint8_t *line, uint8_t *dst, bool first_high, int32_t count,
+                      bool transparent, uint8_t key);
+
 /******************************************************************************/
 /***        exported variables                                              ***/
 /******************************************************************************/
@@ -112,6 +181,13 @@ static const int32_t contrast_cycles_4_white[15] = {10, 10, 8, 8, 8, 8, 8, 10, 1
 static uint8_t *conversion_lut;
 static QueueHandle_t output_queue;
 
+static UpdateStats_t update_stats;
+
+/**
+ * @brief Core the image output tasks are pinned to, -1 to split them over both.
+ */
+static int32_t output_core = -1;
+
 static const DRAM_ATTR uint32_t lut_1bpp[256] = {
     0x0000, 0x0001, 0x0004, 0x0005, 0x0010, 0x0011, 0x0014, 0x0015,
     0x0040, 0x0041, 0x0044, 0x0045, 0x0050, 0x0051, 0x0054, 0x0055,
@@ -159,6 +235,7 @@ void epd_init()
     conversion_lut = (uint8_t *)heap_caps_malloc(1 << 16, MALLOC_CAP_8BIT);
     assert(conversion_lut != NULL);
     output_queue = xQueueCreate(64, EPD_WIDTH / 2);
+    epd_font_init();
 }
 
 
@@ -303,25 +380,79 @@ inline uint32_t min(uint32_t x, uint32_t y)
 
 void epd_draw_hline(int32_t x, int32_t y, int32_t length, uint8_t color, uint8_t *framebuffer)
 {
-    for (int32_t i = 0; i < length; i++)
+    epd_damage_add((Rect_t){.x = x, .y = y, .width = length, .height = 1});
+    fill_hline(x, y, length, color, framebuffer);
+}
+
+
+void epd_draw_vline(int32_t x, int32_t y, int32_t length, uint8_t color, uint8_t *framebuffer)
+{
+    epd_damage_add((Rect_t){.x = x, .y = y, .width = 1, .height = length});
+    fill_vline(x, y, length, color, framebuffer);
+}
+
+
+void epd_draw_pixel(int32_t x, int32_t y, uint8_t color, uint8_t *framebuffer)
+{
+    epd_damage_add((Rect_t){.x = x, .y = y, .width = 1, .height = 1});
+    set_pixel(x, y, color, framebuffer);
+}
+
+
+static void fill_hline(int32_t x, int32_t y, int32_t length, uint8_t color, uint8_t *framebuffer)
+{
+    if (y < 0 || y >= EPD_HEIGHT)
     {
-        int32_t xx = x + i;
-        epd_draw_pixel(xx, y, color, framebuffer);
+        return;
+    }
+    if (x < 0)
+    {
+        length += x;
+        x = 0;
+    }
+    if (x + length > EPD_WIDTH)
+    {
+        length = EPD_WIDTH - x;
+    }
+    if (length <= 0)
+    {
+        return;
+    }
+
+    uint8_t *row = &framebuffer[y * EPD_WIDTH / 2];
+    uint8_t value = color >> 4;
+    int32_t end = x + length;
+
+    // leading odd pixel lives in the high nibble
+    if (x % 2)
+    {
+        row[x / 2] = (row[x / 2] & 0x0F) | (value << 4);
+        x++;
+    }
+    int32_t full_end = end & ~1;
+    if (full_end > x)
+    {
+        memset(&row[x / 2], value | (value << 4), (full_end - x) / 2);
+    }
+    // trailing even pixel lives in the low nibble
+    if (end % 2 && end - 1 >= x)
+    {
+        row[end / 2] = (row[end / 2] & 0xF0) | value;
     }
 }
 
 
-void epd_draw_vline(int32_t x, int32_t y, int32_t length, uint8_t color, uint8_t *framebuffer)
+static void fill_vline(int32_t x, int32_t y, int32_t length, uint8_t color, uint8_t *framebuffer)
 {
     for (int32_t i = 0; i < length; i++)
     {
         int32_t yy = y + i;
-        epd_draw_pixel(x, yy, color, framebuffer);
+        set_pixel(x, yy, color, framebuffer);
     }
 }
 
 
-void epd_draw_pixel(int32_t x, int32_t y, uint8_t color, uint8_t *framebuffer)
+static void set_pixel(int32_t x, int32_t y, uint8_t color, uint8_t *framebuffer)
 {
     if (x < 0 || x >= EPD_WIDTH)
     {
@@ -351,10 +482,11 @@ void epd_draw_circle(int32_t x0, int32_t y0, int32_t r, uint8_t color, uint8_t *
     int32_t x = 0;
     int32_t y = r;
 
-    epd_draw_pixel(x0, y0 + r, color, framebuffer);
-    epd_draw_pixel(x0, y0 - r, color, framebuffer);
-    epd_draw_pixel(x0 + r, y0, color, framebuffer);
-    epd_draw_pixel(x0 - r, y0, color, framebuffer);
+    epd_damage_add((Rect_t){.x = x0 - r, .y = y0 - r, .width = 2 * r + 1, .height = 2 * r + 1});
+    set_pixel(x0, y0 + r, color, framebuffer);
+    set_pixel(x0, y0 - r, color, framebuffer);
+    set_pixel(x0 + r, y0, color, framebuffer);
+    set_pixel(x0 - r, y0, color, framebuffer);
 
     while (x < y)
     {
@@ -368,21 +500,22 @@ void epd_draw_circle(int32_t x0, int32_t y0, int32_t r, uint8_t color, uint8_t *
         ddF_x += 2;
         f += ddF_x;
 
-        epd_draw_pixel(x0 + x, y0 + y, color, framebuffer);
-        epd_draw_pixel(x0 - x, y0 + y, color, framebuffer);
-        epd_draw_pixel(x0 + x, y0 - y, color, framebuffer);
-        epd_draw_pixel(x0 - x, y0 - y, color, framebuffer);
-        epd_draw_pixel(x0 + y, y0 + x, color, framebuffer);
-        epd_draw_pixel(x0 - y, y0 + x, color, framebuffer);
-        epd_draw_pixel(x0 + y, y0 - x, color, framebuffer);
-        epd_draw_pixel(x0 - y, y0 - x, color, framebuffer);
+        set_pixel(x0 + x, y0 + y, color, framebuffer);
+        set_pixel(x0 - x, y0 + y, color, framebuffer);
+        set_pixel(x0 + x, y0 - y, color, framebuffer);
+        set_pixel(x0 - x, y0 - y, color, framebuffer);
+        set_pixel(x0 + y, y0 + x, color, framebuffer);
+        set_pixel(x0 - y, y0 + x, color, framebuffer);
+        set_pixel(x0 + y, y0 - x, color, framebuffer);
+        set_pixel(x0 - y, y0 - x, color, framebuffer);
     }
 }
 
 
 void epd_fill_circle(int32_t x0, int32_t y0, int32_t r, uint8_t color, uint8_t *framebuffer)
 {
-    epd_draw_vline(x0, y0 - r, 2 * r + 1, color, framebuffer);
+    epd_damage_add((Rect_t){.x = x0 - r, .y = y0 - r, .width = 2 * r + 1, .height = 2 * r + 1});
+    fill_vline(x0, y0 - r, 2 * r + 1, color, framebuffer);
     epd_fill_circle_helper(x0, y0, r, 3, 0, color, framebuffer);
 }
 
@@ -416,16 +549,16 @@ static void epd_fill_circle_helper(int32_t x0, int32_t y0, int32_t r, int32_t co
         if (x < (y + 1))
         {
             if (corners & 1)
-                epd_draw_vline(x0 + x, y0 - y, 2 * y + delta, color, framebuffer);
+                fill_vline(x0 + x, y0 - y, 2 * y + delta, color, framebuffer);
             if (corners & 2)
-                epd_draw_vline(x0 - x, y0 - y, 2 * y + delta, color, framebuffer);
+                fill_vline(x0 - x, y0 - y, 2 * y + delta, color, framebuffer);
         }
         if (y != py)
         {
             if (corners & 1)
-                epd_draw_vline(x0 + py, y0 - px, 2 * px + delta, color, framebuffer);
+                fill_vline(x0 + py, y0 - px, 2 * px + delta, color, framebuffer);
             if (corners & 2)
-                epd_draw_vline(x0 - py, y0 - px, 2 * px + delta, color, framebuffer);
+                fill_vline(x0 - py, y0 - px, 2 * px + delta, color, framebuffer);
             py = y;
         }
         px = x;
@@ -435,24 +568,31 @@ static void epd_fill_circle_helper(int32_t x0, int32_t y0, int32_t r, int32_t co
 
 void epd_draw_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint8_t color, uint8_t *framebuffer)
 {
-    epd_draw_hline(x, y, w, color, framebuffer);
-    epd_draw_hline(x, y + h - 1, w, color, framebuffer);
-    epd_draw_vline(x, y, h, color, framebuffer);
-    epd_draw_vline(x + w - 1, y, h, color, framebuffer);
+    epd_damage_add((Rect_t){.x = x, .y = y, .width = w, .height = h});
+    fill_hline(x, y, w, color, framebuffer);
+    fill_hline(x, y + h - 1, w, color, framebuffer);
+    fill_vline(x, y, h, color, framebuffer);
+    fill_vline(x + w - 1, y, h, color, framebuffer);
 }
 
 
 void epd_fill_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint8_t color, uint8_t *framebuffer)
 {
-    for (int32_t i = x; i < x + w; i++)
+    epd_damage_add((Rect_t){.x = x, .y = y, .width = w, .height = h});
+    for (int32_t i = y; i < y + h; i++)
     {
-        epd_draw_vline(i, y, h, color, framebuffer);
+        fill_hline(x, i, w, color, framebuffer);
     }
 }
 
 
 void epd_write_line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t color, uint8_t *framebuffer)
 {
+    epd_damage_add((Rect_t){.x = x0 < x1 ? x0 : x1,
+                            .y = y0 < y1 ? y0 : y1,
+                            .width = abs(x1 - x0) + 1,
+                            .height = abs(y1 - y0) + 1});
+
     int32_t steep = abs(y1 - y0) > abs(x1 - x0);
     if (steep)
     {
@@ -486,11 +626,11 @@ void epd_write_line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t colo
     {
         if (steep)
         {
-            epd_draw_pixel(y0, x0, color, framebuffer);
+            set_pixel(y0, x0, color, framebuffer);
         }
         else
         {
-            epd_draw_pixel(x0, y0, color, framebuffer);
+            set_pixel(x0, y0, color, framebuffer);
         }
         err -= dy;
         if (err < 0)
@@ -555,6 +695,10 @@ void epd_fill_triangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x
         _swap_int(x0, x1);
     }
 
+    int32_t min_x = x0 < x1 ? (x0 < x2 ? x0 : x2) : (x1 < x2 ? x1 : x2);
+    int32_t max_x = x0 > x1 ? (x0 > x2 ? x0 : x2) : (x1 > x2 ? x1 : x2);
+    epd_damage_add((Rect_t){.x = min_x, .y = y0, .width = max_x - min_x + 1, .height = y2 - y0 + 1});
+
     if (y0 == y2)
     { // Handle awkward all-on-same-line case as its own thing
         a = b = x0;
@@ -566,7 +710,7 @@ void epd_fill_triangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x
             a = x2;
         else if (x2 > b)
             b = x2;
-        epd_draw_hline(a, y0, b - a + 1, color, framebuffer);
+        fill_hline(a, y0, b - a + 1, color, framebuffer);
         return;
     }
 
@@ -602,7 +746,7 @@ void epd_fill_triangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x
         */
         if (a > b)
             _swap_int(a, b);
-        epd_draw_hline(a, y, b - a + 1, color, framebuffer);
+        fill_hline(a, y, b - a + 1, color, framebuffer);
     }
 
     // For lower part of triangle, find scanline crossings for segments
@@ -621,48 +765,135 @@ void epd_fill_triangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x
         */
         if (a > b)
             _swap_int(a, b);
-        epd_draw_hline(a, y, b - a + 1, color, framebuffer);
+        fill_hline(a, y, b - a + 1, color, framebuffer);
     }
 }
 
 
+void epd_fill_polygon(const Point_t *points, int32_t count, FillRule_t rule,
+                      uint8_t color, uint8_t *framebuffer)
+{
+    fill_polygon(points, count, rule, color, framebuffer, 0);
+}
+
+
+void epd_fill_polygon_aa(const Point_t *points, int32_t count, FillRule_t rule,
+                         uint8_t color, uint8_t *framebuffer)
+{
+    fill_polygon(points, count, rule, color, framebuffer, 2);
+}
+
+
 void epd_copy_to_framebuffer(Rect_t image_area, uint8_t *image_data,
                              uint8_t *framebuffer)
 {
-    assert(image_data != NULL || framebuffer != NULL);
+    epd_blit(image_area, image_data, framebuffer, 0, 0);
+}
+
 
-    for (uint32_t i = 0; i < image_area.width * image_area.height; i++)
+void epd_blit(Rect_t image_area, const uint8_t *image_data, uint8_t *framebuffer,
+              uint32_t flags, uint8_t key)
+{
+    assert(image_data != NULL && framebuffer != NULL);
+
+    int32_t x0 = image_area.x < 0 ? 0 : image_area.x;
+    int32_t y0 = image_area.y < 0 ? 0 : image_area.y;
+    int32_t x1 = image_area.x + image_area.width;
+    int32_t y1 = image_area.y + image_area.height;
+    if (x1 > EPD_WIDTH)
+        x1 = EPD_WIDTH;
+    if (y1 > EPD_HEIGHT)
+        y1 = EPD_HEIGHT;
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+    epd_damage_add(image_area);
+
+    // Images of uneven width carry a padding nibble per row
+    int32_t src_stride = (image_area.width + 1) / 2;
+    int32_t count = x1 - x0;
+    bool first_high = x0 % 2;
+    // Image nibble that lands in the low nibble of the first framebuffer byte
+    int32_t start = (x0 - image_area.x) - first_high;
+    int32_t line_len = (first_high + count + 1) / 2;
+    bool swap = flags & BLIT_SWAP_NIBBLES;
+    bool transparent = flags & BLIT_TRANSPARENT;
+    bool aligned = start % 2 == 0 && !swap;
+
+    uint8_t line[EPD_WIDTH / 2];
+    for (int32_t y = y0; y < y1; y++)
     {
-        uint32_t value_index = i;
-        // for images of uneven width,
-        // consume an additional nibble per row.
-        if (image_area.width % 2)
+        const uint8_t *src = &image_data[(y - image_area.y) * src_stride];
+        const uint8_t *row = &src[start / 2];
+        if (!aligned)
         {
-            value_index += i / image_area.width;
+            build_blit_line(src, src_stride, start, line_len, swap, line);
+            row = line;
         }
-        uint8_t val = (value_index % 2) ? (image_data[value_index / 2] & 0xF0) >> 4
-                                        : image_data[value_index / 2] & 0x0F;
-
-        int32_t xx = image_area.x + i % image_area.width;
-        if (xx < 0 || xx >= EPD_WIDTH)
+        // Rows that are transparent throughout leave the framebuffer as it is
+        if (transparent && epd_swar_all_equal(row, line_len, key))
         {
             continue;
         }
-        int32_t yy = image_area.y + i / image_area.width;
-        if (yy < 0 || yy >= EPD_HEIGHT)
+        blit_line(row, &framebuffer[y * EPD_WIDTH / 2 + x0 / 2], first_high, count,
+                  transparent, key);
+    }
+}
+
+
+void epd_remap_palette(const uint8_t *palette, uint8_t *framebuffer)
+{
+    uint8_t lut[256];
+    build_palette_lut(palette, lut);
+
+    uint32_t *words = (uint32_t *)framebuffer;
+    for (int32_t i = 0; i < EPD_WIDTH / 2 * EPD_HEIGHT / 4; i++)
+    {
+        words[i] = epd_swar_remap(words[i], lut);
+    }
+    epd_damage_add(epd_full_screen());
+}
+
+
+void epd_remap_palette_area(Rect_t area, const uint8_t *palette, uint8_t *framebuffer)
+{
+    int32_t x0 = area.x < 0 ? 0 : area.x;
+    int32_t y0 = area.y < 0 ? 0 : area.y;
+    int32_t x1 = area.x + area.width < EPD_WIDTH ? area.x + area.width : EPD_WIDTH;
+    int32_t y1 = area.y + area.height < EPD_HEIGHT ? area.y + area.height : EPD_HEIGHT;
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    uint8_t lut[256];
+    build_palette_lut(palette, lut);
+
+    for (int32_t y = y0; y < y1; y++)
+    {
+        uint8_t *row = &framebuffer[y * EPD_WIDTH / 2];
+        int32_t x = x0;
+        if (x % 2)
         {
-            continue;
+            // odd pixels are the high nibble
+            row[x / 2] = (row[x / 2] & 0x0F) | (palette[row[x / 2] >> 4] << 4);
+            x++;
         }
-        uint8_t *buf_ptr = &framebuffer[yy * EPD_WIDTH / 2 + xx / 2];
-        if (xx % 2)
+        for (; x + 7 < x1; x += 8)
         {
-            *buf_ptr = (*buf_ptr & 0x0F) | (val << 4);
+            epd_swar_store(&row[x / 2], epd_swar_remap(epd_swar_load(&row[x / 2]), lut));
         }
-        else
+        for (; x + 1 < x1; x += 2)
         {
-            *buf_ptr = (*buf_ptr & 0xF0) | val;
+            row[x / 2] = lut[row[x / 2]];
+        }
+        if (x < x1)
+        {
+            row[x / 2] = (row[x / 2] & 0xF0) | (palette[row[x / 2] & 0x0F] & 0x0F);
         }
     }
+    epd_damage_add(area);
 }
 
 
@@ -738,7 +969,7 @@ void IRAM_ATTR epd_draw_frame_1bit(Rect_t area, uint8_t *ptr,
             {
                 // shift to right
                 shifted = true;
-                bit_shift_buffer_right(
+                epd_swar_bit_shift_buffer(
                     buf_start,
                     min(line_bytes + 1,
                         (uint32_t)line + EPD_WIDTH / 8 - (uint32_t)buf_start),
@@ -761,9 +992,44 @@ void IRAM_ATTR epd_draw_frame_1bit(Rect_t area, uint8_t *ptr,
 }
 
 
+void epd_get_update_stats(UpdateStats_t *stats)
+{
+    *stats = update_stats;
+}
+
+
+void epd_reset_update_stats()
+{
+    memset(&update_stats, 0, sizeof(update_stats));
+}
+
+
+void epd_set_output_core(int32_t core)
+{
+    output_core = core;
+}
+
+
 void IRAM_ATTR epd_draw_image(Rect_t area, uint8_t *data, DrawMode_t mode)
+{
+    epd_draw_image_masked(area, data, mode, NULL);
+}
+
+
+void IRAM_ATTR epd_draw_image_masked(Rect_t area, uint8_t *data, DrawMode_t mode,
+                                     const uint8_t *row_mask)
+{
+    epd_draw_image_strided(area, data, 0, area.width / 2 + area.width % 2, mode, row_mask);
+}
+
+
+void IRAM_ATTR epd_draw_image_strided(Rect_t area, const uint8_t *data, int32_t src_x,
+                                      int32_t stride, DrawMode_t mode,
+                                      const uint8_t *row_mask)
 {
     uint8_t frame_count = 15;
+    update_stats.updates++;
+    update_stats.frames += frame_count;
 
     SemaphoreHandle_t fetch_sem = xSemaphoreCreateBinary();
     SemaphoreHandle_t feed_sem = xSemaphoreCreateBinary();
@@ -773,23 +1039,29 @@ void IRAM_ATTR epd_draw_image(Rect_t area, uint8_t *data, DrawMode_t mode)
         OutputParams p1 = {
             .area = area,
             .data_ptr = data,
+            .src_x = src_x,
+            .stride = stride,
             .frame = k,
             .mode = mode,
+            .row_mask = row_mask,
             .done_smphr = fetch_sem,
         };
         OutputParams p2 = {
             .area = area,
             .data_ptr = data,
+            .src_x = src_x,
+            .stride = stride,
             .frame = k,
             .mode = mode,
+            .row_mask = row_mask,
             .done_smphr = feed_sem,
         };
 
         TaskHandle_t t1, t2;
         xTaskCreatePinnedToCore((void (*)(void *))provide_out, "privide_out", 8192,
-                                &p1, 10, &t1, 0);
+                                &p1, 10, &t1, output_core < 0 ? 0 : output_core);
         xTaskCreatePinnedToCore((void (*)(void *))feed_display, "render", 8192, &p2,
-                                10, &t2, 1);
+                                10, &t2, output_core < 0 ? 1 : output_core);
 
         xSemaphoreTake(fetch_sem, portMAX_DELAY);
         xSemaphoreTake(feed_sem, portMAX_DELAY);
@@ -913,34 +1185,219 @@ static void IRAM_ATTR update_LUT(uint8_t *lut_mem, uint8_t k, DrawMode_t mode)
 }
 
 
-static void IRAM_ATTR bit_shift_buffer_right(uint8_t *buf, uint32_t len, int32_t shift)
+static int compare_edges(const void *a, const void *b)
 {
-    uint8_t carry = 0x00;
-    for (uint32_t i = 0; i < len; i++)
+    return ((const PolygonEdge *)a)->y_top - ((const PolygonEdge *)b)->y_top;
+}
+
+
+static void fill_polygon(const Point_t *points, int32_t count, FillRule_t rule,
+                         uint8_t color, uint8_t *framebuffer, int32_t shift)
+{
+    if (points == NULL || count < 3)
+    {
+        return;
+    }
+
+    Point_t lo = points[0], hi = points[0];
+    for (int32_t i = 1; i < count; i++)
+    {
+        lo.x = points[i].x < lo.x ? points[i].x : lo.x;
+        lo.y = points[i].y < lo.y ? points[i].y : lo.y;
+        hi.x = points[i].x > hi.x ? points[i].x : hi.x;
+        hi.y = points[i].y > hi.y ? points[i].y : hi.y;
+    }
+    epd_damage_add((Rect_t){.x = lo.x, .y = lo.y, .width = hi.x - lo.x + 1, .height = hi.y - lo.y + 1});
+
+    const int32_t samples = 1 << shift;
+    PolygonEdge *edges = (PolygonEdge *)malloc(count * sizeof(PolygonEdge));
+    PolygonEdge **active = (PolygonEdge **)malloc(count * sizeof(PolygonEdge *));
+    uint8_t *coverage = shift ? (uint8_t *)calloc(EPD_WIDTH, 1) : NULL;
+    if (edges == NULL || active == NULL || (shift && coverage == NULL))
+    {
+        ESP_LOGE("epd_driver", "cannot allocate polygon edge table!");
+        goto cleanup;
+    }
+
+    // build the edge table, horizontal edges never cross a sample center
+    int32_t edge_count = 0;
+    int32_t min_y = 0, max_y = 0;
+    for (int32_t i = 0; i < count; i++)
+    {
+        Point_t a = points[i];
+        Point_t b = points[(i + 1) % count];
+        if (a.y == b.y)
+        {
+            continue;
+        }
+
+        PolygonEdge *e = &edges[edge_count++];
+        e->winding = 1;
+        if (a.y > b.y)
+        {
+            Point_t t = a;
+            a = b;
+            b = t;
+            e->winding = -1;
+        }
+        e->y_top = a.y * samples;
+        e->y_bottom = b.y * samples;
+        e->x_top = a.x * 65536;
+        e->dx = (int32_t)((int64_t)(b.x - a.x) * 65536 / (e->y_bottom - e->y_top));
+
+        if (edge_count == 1 || e->y_top < min_y)
+            min_y = e->y_top;
+        if (edge_count == 1 || e->y_bottom > max_y)
+            max_y = e->y_bottom;
+    }
+    qsort(edges, edge_count, sizeof(PolygonEdge),
+          compare_edges);
+
+    int32_t y_start = min_y < 0 ? 0 : min_y;
+    int32_t y_end = max_y > EPD_HEIGHT * samples ? EPD_HEIGHT * samples : max_y;
+    int32_t next_edge = 0;
+    int32_t active_count = 0;
+    int32_t cov_min = EPD_WIDTH, cov_max = -1;
+
+    for (int32_t sy = y_start; sy < y_end; sy++)
     {
-        uint8_t val = buf[i];
-        buf[i] = (val << shift) | carry;
-        carry = val >> (8 - shift);
+        // retire edges ending above this scanline
+        int32_t n = 0;
+        for (int32_t i = 0; i < active_count; i++)
+        {
+            if (active[i]->y_bottom > sy)
+            {
+                active[n++] = active[i];
+            }
+        }
+        active_count = n;
+
+        // activate edges starting at (or, when clipped, above) this scanline
+        while (next_edge < edge_count && edges[next_edge].y_top <= sy)
+        {
+            PolygonEdge *e = &edges[next_edge++];
+            if (e->y_bottom <= sy)
+            {
+                continue;
+            }
+            // sample at the scanline center
+            e->x = e->x_top + (int32_t)((int64_t)e->dx * (2 * (sy - e->y_top) + 1) / 2);
+            active[active_count++] = e;
+        }
+
+        // the active list stays nearly sorted between scanlines
+        for (int32_t i = 1; i < active_count; i++)
+        {
+            PolygonEdge *e = active[i];
+            int32_t j = i - 1;
+            while (j >= 0 && active[j]->x > e->x)
+            {
+                active[j + 1] = active[j];
+                j--;
+            }
+            active[j + 1] = e;
+        }
+
+        int32_t winding = 0;
+        int32_t span_start = 0;
+        for (int32_t i = 0; i < active_count; i++)
+        {
+            PolygonEdge *e = active[i];
+            bool inside_before = rule == FILL_EVEN_ODD ? (winding & 1) : (winding != 0);
+            winding += rule == FILL_EVEN_ODD ? 1 : e->winding;
+            bool inside_after = rule == FILL_EVEN_ODD ? (winding & 1) : (winding != 0);
+
+            if (!inside_before && inside_after)
+            {
+                span_start = e->x;
+            }
+            else if (inside_before && !inside_after)
+            {
+                // pixels whose centers lie in [span_start, e->x)
+                int32_t x0 = (span_start + 0x7FFF) >> 16;
+                int32_t x1 = (e->x + 0x7FFF) >> 16;
+                if (!shift)
+                {
+                    fill_hline(x0, sy, x1 - x0, color, framebuffer);
+                    continue;
+                }
+                if (x0 < 0)
+                    x0 = 0;
+                if (x1 > EPD_WIDTH)
+                    x1 = EPD_WIDTH;
+                if (x0 >= x1)
+                    continue;
+                for (int32_t x = x0; x < x1; x++)
+                {
+                    coverage[x]++;
+                }
+                if (x0 < cov_min)
+                    cov_min = x0;
+                if (x1 - 1 > cov_max)
+                    cov_max = x1 - 1;
+            }
+        }
+
+        for (int32_t i = 0; i < active_count; i++)
+        {
+            active[i]->x += active[i]->dx;
+        }
+
+        if (shift && ((sy + 1) % samples == 0 || sy + 1 == y_end))
+        {
+            flush_coverage(coverage, cov_min, cov_max, sy >> shift, samples, color, framebuffer);
+            cov_min = EPD_WIDTH;
+            cov_max = -1;
+        }
     }
+
+cleanup:
+    free(edges);
+    free(active);
+    free(coverage);
 }
 
-static void IRAM_ATTR nibble_shift_buffer_right(uint8_t *buf, uint32_t len)
+
+static void flush_coverage(uint8_t *coverage, int32_t x_min, int32_t x_max, int32_t y,
+                           int32_t full, uint8_t color, uint8_t *framebuffer)
 {
-    uint8_t carry = 0xF;
-    for (uint32_t i = 0; i < len; i++)
+    uint8_t value = color >> 4;
+    int32_t x = x_min;
+    while (x <= x_max)
     {
-        uint8_t val = buf[i];
-        buf[i] = (val << 4) | carry;
-        carry = (val & 0xF0) >> 4;
+        if (coverage[x] == full)
+        {
+            // fully covered runs go through the fast hline path
+            int32_t run = x;
+            while (run <= x_max && coverage[run] == full)
+            {
+                coverage[run++] = 0;
+            }
+            fill_hline(x, y, run - x, color, framebuffer);
+            x = run;
+            continue;
+        }
+        if (coverage[x])
+        {
+            // blend partially covered pixels with what is underneath
+            uint8_t *buf_ptr = &framebuffer[y * EPD_WIDTH / 2 + x / 2];
+            int32_t old = (x % 2) ? *buf_ptr >> 4 : *buf_ptr & 0x0F;
+            int32_t blended = old + ((value - old) * coverage[x] + (value > old ? full / 2 : -full / 2)) / full;
+            epd_draw_pixel(x, y, blended << 4, framebuffer);
+            coverage[x] = 0;
+        }
+        x++;
     }
 }
 
+
 static void IRAM_ATTR provide_out(OutputParams *params)
 {
     uint8_t line[EPD_WIDTH / 2];
     memset(line, 255, EPD_WIDTH / 2);
     Rect_t area = params->area;
-    uint8_t *ptr = params->data_ptr;
+    const uint8_t *ptr = params->data_ptr;
+    int32_t stride = params->stride;
 
     if (params->frame == 0)
     {
@@ -949,14 +1406,23 @@ static void IRAM_ATTR provide_out(OutputParams *params)
 
     update_LUT(conversion_lut, params->frame, params->mode);
 
-    if (area.x < 0)
+    if (area.y < 0)
     {
-        ptr += -area.x / 2;
+        ptr += stride * -area.y;
     }
-    if (area.y < 0)
+
+    // Columns of the area on screen, and where they start in the source rows
+    int32_t x0 = area.x < 0 ? 0 : area.x > EPD_WIDTH ? EPD_WIDTH : area.x;
+    int32_t x1 = area.x + area.width > EPD_WIDTH ? EPD_WIDTH : area.x + area.width;
+    if (x1 < x0)
     {
-        ptr += (area.width / 2 + area.width % 2) * -area.y;
+        x1 = x0;
     }
+    bool first_high = x0 % 2;
+    int32_t start = params->src_x + (x0 - area.x) - first_high;
+    int32_t line_bytes = (first_high + (x1 - x0) + 1) / 2;
+    bool last_low = (first_high + (x1 - x0)) % 2;
+    uint8_t *buf_start = &line[x0 / 2];
 
     for (int32_t i = 0; i < EPD_HEIGHT; i++)
     {
@@ -964,52 +1430,41 @@ static void IRAM_ATTR provide_out(OutputParams *params)
         {
             continue;
         }
+        if (!row_selected(params->row_mask, i - area.y))
+        {
+            ptr += stride;
+            continue;
+        }
 
-        uint32_t *lp;
-        bool shifted = false;
-        if (area.width == EPD_WIDTH && area.x == 0)
+        const uint32_t *lp;
+        if (area.width == EPD_WIDTH && area.x == 0 && params->src_x == 0)
         {
-            lp = (uint32_t *)ptr;
-            ptr += EPD_WIDTH / 2;
+            lp = (const uint32_t *)ptr;
         }
         else
         {
-            uint8_t *buf_start = (uint8_t *)line;
-            uint32_t line_bytes = area.width / 2 + area.width % 2;
-            if (area.x >= 0)
+            if (start % 2 == 0)
             {
-                buf_start += area.x / 2;
+                memcpy(buf_start, &ptr[start / 2], line_bytes);
             }
             else
             {
-                // reduce line_bytes to actually used bytes
-                line_bytes += area.x / 2;
+                build_blit_line(ptr, stride, start, line_bytes, false, buf_start);
             }
-            line_bytes =
-                min(line_bytes, EPD_WIDTH / 2 - (uint32_t)(buf_start - line));
-            memcpy(buf_start, ptr, line_bytes);
-            ptr += area.width / 2 + area.width % 2;
 
-            // mask last nibble for uneven width
-            if (area.width % 2 == 1 && area.x / 2 + area.width / 2 + 1 < EPD_WIDTH)
+            // Neighbouring pixels sharing a byte with the edges are not driven
+            if (first_high)
             {
-                *(buf_start + line_bytes - 1) |= 0xF0;
+                buf_start[0] |= 0x0F;
             }
-            if (area.x % 2 == 1 && area.x < EPD_WIDTH)
+            if (last_low)
             {
-                shifted = true;
-                // shift one nibble to right
-                nibble_shift_buffer_right(
-                    buf_start, min(line_bytes + 1, (uint32_t)line + EPD_WIDTH / 2 -
-                                                       (uint32_t)buf_start));
+                buf_start[line_bytes - 1] |= 0xF0;
             }
-            lp = (uint32_t *)line;
+            lp = (const uint32_t *)line;
         }
+        ptr += stride;
         xQueueSendToBack(output_queue, lp, portMAX_DELAY);
-        if (shifted)
-        {
-            memset(line, 255, EPD_WIDTH / 2);
-        }
     }
 
     xSemaphoreGive(params->done_smphr);
@@ -1038,12 +1493,22 @@ static void IRAM_ATTR feed_display(OutputParams *params)
         if (i < area.y || i >= area.y + area.height)
         {
             skip_row(contrast_lut[params->frame]);
+            update_stats.rows_skipped++;
+            continue;
+        }
+        if (!row_selected(params->row_mask, i - area.y))
+        {
+            skip_row(contrast_lut[params->frame]);
+            update_stats.rows_skipped++;
+            update_stats.rows_unchanged++;
             continue;
         }
         uint8_t output[EPD_WIDTH / 2];
         xQueueReceive(output_queue, output, portMAX_DELAY);
         calc_epd_input_4bpp((uint32_t *)output, epd_get_current_buffer(),
                             params->frame, conversion_lut);
+        update_stats.rows_written++;
+        update_stats.bytes_converted += EPD_WIDTH / 2;
         write_row(contrast_lut[params->frame]);
     }
     if (!skipping)
@@ -1057,6 +1522,111 @@ static void IRAM_ATTR feed_display(OutputParams *params)
     vTaskDelay(portMAX_DELAY);
 }
 
+
+static void build_blit_line(const uint8_t *src, int32_t src_len, int32_t start, int32_t len,
+                            bool swap, uint8_t *line)
+{
+    // start is even here or the line is shifted by one nibble, then byte i
+    // takes the high nibble of one image byte and the low nibble of the next
+    int32_t shift = start & 1;
+    int32_t first = (start - shift) / 2;
+    int32_t i = 0;
+
+    // A leading -1 nibble reads before the row, leave it to the scalar tail
+    int32_t word_start = first < 0 ? 1 : 0;
+    for (; i < word_start && i < len; i++)
+    {
+        uint8_t hi = first + i + 1 < src_len ? src[first + i + 1] : 0;
+        if (swap)
+            hi = epd_swar_swap(hi);
+        line[i] = shift ? hi << 4 : 0;
+    }
+
+    // Four bytes at a time, the next byte supplies the nibble shifted in
+    for (; i + 4 < len && first + i + 4 < src_len; i += 4)
+    {
+        uint32_t word = epd_swar_load(&src[first + i]);
+        uint32_t next = src[first + i + 4];
+        if (swap)
+        {
+            word = epd_swar_swap(word);
+            next = epd_swar_swap(next);
+        }
+        if (shift)
+            word = epd_swar_shift(word, next);
+        epd_swar_store(&line[i], word);
+    }
+
+    for (; i < len; i++)
+    {
+        uint8_t lo = first + i < src_len ? src[first + i] : 0;
+        uint8_t hi = first + i + 1 < src_len ? src[first + i + 1] : 0;
+        if (swap)
+        {
+            lo = epd_swar_swap(lo);
+            hi = epd_swar_swap(hi);
+        }
+        line[i] = shift ? (lo >> 4) | (hi << 4) : lo;
+    }
+}
+
+
+static inline uint8_t blit_mask(uint8_t value, bool transparent, uint8_t key)
+{
+    return transparent ? (uint8_t)epd_swar_ne_mask(value, key) : 0xFF;
+}
+
+
+static void blit_line(const uint8_t *line, uint8_t *dst, bool first_high, int32_t count,
+                      bool transparent, uint8_t key)
+{
+    int32_t end = first_high + count;
+    int32_t i = 0;
+    if (first_high)
+    {
+        uint8_t mask = blit_mask(line[0], transparent, key) & 0xF0;
+        dst[0] = (dst[0] & ~mask) | (line[0] & mask);
+        i = 1;
+    }
+
+    int32_t whole_end = end / 2;
+    if (!transparent)
+    {
+        if (whole_end > i)
+            memcpy(&dst[i], &line[i], whole_end - i);
+        i = whole_end;
+    }
+    else
+    {
+        // Nibbles equal to the key keep the framebuffer
+        for (; i + 4 <= whole_end; i += 4)
+        {
+            uint32_t word = epd_swar_load(&line[i]);
+            epd_swar_store(&dst[i], epd_swar_merge_key(epd_swar_load(&dst[i]), word, key));
+        }
+    }
+    for (; i < whole_end; i++)
+    {
+        uint8_t mask = blit_mask(line[i], transparent, key);
+        dst[i] = (dst[i] & ~mask) | (line[i] & mask);
+    }
+
+    if (end % 2)
+    {
+        uint8_t mask = blit_mask(line[whole_end], transparent, key) & 0x0F;
+        dst[whole_end] = (dst[whole_end] & ~mask) | (line[whole_end] & mask);
+    }
+}
+
+
+static void build_palette_lut(const uint8_t *palette, uint8_t *lut)
+{
+    for (int32_t i = 0; i < 256; i++)
+    {
+        lut[i] = (palette[i >> 4] << 4) | (palette[i & 0x0F] & 0x0F);
+    }
+}
+
 /******************************************************************************/
 /***        END OF FILE                                                     ***/
 /******************************************************************************/
\ No newline at end of file
@@ -63,6 +63,27 @@ typedef enum
 enum DrawFlags
 {
     DRAW_BACKGROUND = 1 << 0, /** Draw a background. Take the background into account when calculating the size. */
+    DRAW_COMPOSITE  = 1 << 1, /** Blend glyph edges into the framebuffer instead of toward `bg_color`, e.g. for text over images. */
+};
+
+/**
+ * @brief Flags for `epd_blit`.
+ */
+enum BlitFlags
+{
+    BLIT_TRANSPARENT  = 1 << 0, /** Leave the framebuffer alone where the image pixel equals the key. */
+    BLIT_SWAP_NIBBLES = 1 << 1, /** The image has its left pixel in the high nibble of each byte. */
+};
+
+/**
+ * @brief Compression of the glyph bitmaps of a font.
+ */
+enum GlyphCodec
+{
+    GLYPH_CODEC_NONE    = 0, /** Plain 4 bit bitmaps. */
+    GLYPH_CODEC_ZLIB    = 1, /** A zlib stream per glyph. */
+    GLYPH_CODEC_RLE     = 2, /** Runs of blank and full pixels, larger than zlib but faster to decode. */
+    GLYPH_CODEC_DEFLATE = 3, /** A raw deflate stream per glyph, zlib without the header and checksum. */
 };
 
 /**
@@ -76,6 +97,37 @@ typedef struct
     uint32_t flags;          /** Additional flags, reserved for future use */
 } FontProperties;
 
+/**
+ * @brief A point on the display.
+ */
+typedef struct
+{
+    int32_t x; /** Horizontal position. */
+    int32_t y; /** Vertical position. */
+} Point_t;
+
+/**
+ * @brief Rule deciding which regions of a self-intersecting polygon are filled.
+ */
+typedef enum
+{
+    FILL_EVEN_ODD = 0, /** Fill where a ray crosses an odd number of edges. */
+    FILL_NONZERO  = 1, /** Fill where the winding number is not zero. */
+} FillRule_t;
+
+/**
+ * @brief Work done by image draws since the last stats reset.
+ */
+typedef struct
+{
+    uint32_t updates;         /** Number of image draws. */
+    uint32_t frames;          /** Number of frames driven, 15 per image draw. */
+    uint32_t rows_written;    /** Panel rows driven with pixel data, over all frames. */
+    uint32_t rows_skipped;    /** Panel rows skipped, over all frames. */
+    uint32_t rows_unchanged;  /** Skipped rows inside the area, excluded by a row mask. */
+    uint32_t bytes_converted; /** Framebuffer bytes run through the output LUT. */
+} UpdateStats_t;
+
 /******************************************************************************/
 /***        exported variables                                              ***/
 /******************************************************************************/
@@ -159,8 +211,64 @@ void IRAM_ATTR epd_draw_grayscale_image(Rect_t area, uint8_t *data);
  */
 void IRAM_ATTR epd_draw_image(Rect_t area, uint8_t *data, DrawMode_t mode);
 
+/**
+ * @brief Draw a picture to a given area, driving only the rows selected by a
+ *        row mask.
+ *
+ * @note Rows not in the mask are output as no-op rows, the panel keeps what it
+ *       shows there. Use this for rows known to be unchanged on the display.
+ *
+ * @param area     The display area to draw to, as for `epd_draw_image`.
+ * @param data     The image data, as for `epd_draw_image`.
+ * @param mode     The draw mode.
+ * @param row_mask One bit per row of `area`, LSB first: row `r` is drawn if
+ *                 `row_mask[r / 8] & (1 << (r % 8))` is set. NULL draws all
+ *                 rows.
+ */
+void IRAM_ATTR epd_draw_image_masked(Rect_t area, uint8_t *data, DrawMode_t mode,
+                                     const uint8_t *row_mask);
+
+/**
+ * @brief Draw a region of a larger image, e.g. a sub-rect of the framebuffer,
+ *        without copying it out first.
+ *
+ * @param area     The display area to draw to.
+ * @param data     The first source row of the region.
+ * @param src_x    Pixel column of the region's left edge in the source rows,
+ *                 counting from the low nibble of `data[0]`.
+ * @param stride   Bytes from one source row to the next, `EPD_WIDTH / 2` for
+ *                 the framebuffer.
+ * @param mode     The draw mode.
+ * @param row_mask As for `epd_draw_image_masked`, may be NULL.
+ */
+void IRAM_ATTR epd_draw_image_strided(Rect_t area, const uint8_t *data, int32_t src_x,
+                                      int32_t stride, DrawMode_t mode,
+                                      const uint8_t *row_mask);
+
 void IRAM_ATTR epd_draw_frame_1bit(Rect_t area, uint8_t *ptr, DrawMode_t mode, int32_t time);
 
+/**
+ * @brief Get the work done by image draws since the last call to
+ *        `epd_reset_update_stats`.
+ */
+void epd_get_update_stats(UpdateStats_t *stats);
+
+/**
+ * @brief Reset the image draw statistics.
+ */
+void epd_reset_update_stats();
+
+/**
+ * @brief Pin the two tasks that output an image to one core, e.g. the core of
+ *        the task that draws, so they don't preempt work on the other core.
+ *
+ * @note Split over both cores, the default, rows are prepared on one core
+ *       while the other outputs the previous ones.
+ *
+ * @param core The core, -1 to run one task on each core.
+ */
+void epd_set_output_core(int32_t core);
+
 /**
  * @brief Rectancle representing the whole screen area.
  */
@@ -181,6 +289,45 @@ Rect_t epd_full_screen();
 void epd_copy_to_framebuffer(Rect_t image_area, uint8_t *image_data,
                              uint8_t *framebuffer);
 
+/**
+ * @brief Copy an image into the framebuffer, clipped to the screen.
+ *
+ * @note Works a row at a time: rows at the same nibble alignment as the
+ *       framebuffer are copied with memcpy, others are shifted by a nibble a
+ *       word at a time.
+ *
+ * @param image_area  The area to copy to, as for `epd_copy_to_framebuffer`.
+ * @param image_data  The image data, rows padded to whole bytes.
+ * @param framebuffer The framebuffer to draw into.
+ * @param flags       A combination of `BlitFlags`.
+ * @param key         The transparent color if `BLIT_TRANSPARENT` is set.
+ */
+void epd_blit(Rect_t image_area, const uint8_t *image_data, uint8_t *framebuffer,
+              uint32_t flags, uint8_t key);
+
+/**
+ * @brief Replace every gray value of a framebuffer through a palette, e.g. to
+ *        switch between a light and a dark theme without redrawing.
+ *
+ * @note The whole screen is marked as damaged.
+ *
+ * @param palette     16 entries, the new 4 bit gray value for each old one.
+ * @param framebuffer The framebuffer object, which must
+ *                    be `EPD_WIDTH / 2 * EPD_HEIGHT` large.
+ */
+void epd_remap_palette(const uint8_t *palette, uint8_t *framebuffer);
+
+/**
+ * @brief Replace the gray values inside an area through a palette, e.g. to
+ *        invert a pressed button.
+ *
+ * @param area        The area to recolor, clipped to the screen.
+ * @param palette     16 entries, the new 4 bit gray value for each old one.
+ * @param framebuffer The framebuffer object, which must
+ *                    be `EPD_WIDTH / 2 * EPD_HEIGHT` large.
+ */
+void epd_remap_palette_area(Rect_t area, const uint8_t *palette, uint8_t *framebuffer);
+
 /**
  * @brief Draw a pixel a given framebuffer.
  *
@@ -315,6 +462,32 @@ void epd_draw_triangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x
  */
 void epd_fill_triangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint8_t color, uint8_t *framebuffer);
 
+/**
+ * @brief Fill an arbitrary (possibly concave or self-intersecting) polygon.
+ *
+ * @note The polygon is closed implicitly, the last point connects to the
+ *       first. Pixels are filled if their center lies inside the polygon.
+ *
+ * @param points      The polygon vertices
+ * @param count       Number of vertices, at least 3
+ * @param rule        The fill rule for self-intersecting outlines
+ * @param color       The gray value of the fill (0-255);
+ * @param framebuffer The framebuffer to draw to
+ */
+void epd_fill_polygon(const Point_t *points, int32_t count, FillRule_t rule, uint8_t color, uint8_t *framebuffer);
+
+/**
+ * @brief Fill a polygon with 4x vertical supersampling, blending partially
+ *        covered pixels on the top and bottom edges with the framebuffer.
+ *
+ * @param points      The polygon vertices
+ * @param count       Number of vertices, at least 3
+ * @param rule        The fill rule for self-intersecting outlines
+ * @param color       The gray value of the fill (0-255);
+ * @param framebuffer The framebuffer to draw to
+ */
+void epd_fill_polygon_aa(const Point_t *points, int32_t count, FillRule_t rule, uint8_t color, uint8_t *framebuffer);
+
 /**
  * @brief Font data stored PER GLYPH
  */
@@ -325,7 +498,7 @@ typedef struct
     uint8_t advance_x;        /** Distance to advance cursor (x axis) */
     int16_t left;             /** X dist from cursor pos to UL corner */
     int16_t top;              /** Y dist from cursor pos to UL corner */
-    uint16_t compressed_size; /** Size of the zlib-compressed font data. */
+    uint16_t compressed_size; /** Size of the compressed font data. */
     uint32_t data_offset;     /** Pointer into GFXfont->bitmap */
 } GFXglyph;
 
@@ -339,6 +512,11 @@ typedef struct
     uint32_t offset; /** Index of the first code point into the glyph array */
 } UnicodeInterval;
 
+/**
+ * @brief Entry of `GFXfont->direct_index` for code points without a glyph.
+ */
+#define GLYPH_INDEX_NONE 0xFFFF
+
 /**
  * @brief Data stored for FONT AS A WHOLE
  */
@@ -346,14 +524,50 @@ typedef struct
 {
     uint8_t         *bitmap;         /** Glyph bitmaps, concatenated */
     GFXglyph        *glyph;          /** Glyph array */
-    UnicodeInterval *intervals;      /** Valid unicode intervals for this font */
+    UnicodeInterval *intervals;      /** Valid unicode intervals for this font, ascending */
     uint32_t         interval_count; /** Number of unicode intervals. */
-    bool             compressed;     /** Does this font use compressed glyph bitmaps? */
+    uint8_t          compressed;     /** The `GlyphCodec` of the glyph bitmaps, 0 if uncompressed */
     uint8_t          advance_y;      /** Newline distance (y axis) */
     int32_t          ascender;       /** Maximal height of a glyph above the base line */
     int32_t          descender;      /** Maximal height of a glyph below the base line */
+    const uint16_t  *direct_index;   /** Glyph index of every code point below direct_count, may be NULL */
+    uint32_t         direct_count;   /** Number of code points in direct_index. */
+    struct FontFile *file;           /** Font file the glyph bitmaps are paged in from, NULL if they are in bitmap */
 } GFXfont;
 
+/**
+ * @brief A glyph placed on a line of text.
+ */
+typedef struct
+{
+    const GFXglyph *glyph; /** The glyph, the fallback glyph for missing code points */
+    int32_t         x;     /** Cursor position relative to the start of the run */
+} PlacedGlyph;
+
+/**
+ * @brief A string laid out in one font, to measure and draw it without
+ *        decoding it again.
+ */
+typedef struct
+{
+    const GFXfont *font;    /** The font the run was laid out in */
+    PlacedGlyph   *glyphs;  /** Glyphs in drawing order */
+    int32_t        count;   /** Number of glyphs */
+    int32_t        advance; /** Cursor advance of the whole run */
+    Rect_t         bounds;  /** Ink bounds relative to the start of the base line */
+} GlyphRun;
+
+/**
+ * @brief Allocate the glyph and text caches and the buffer of text drawn
+ *        without a framebuffer, so drawing text does not touch the heap.
+ *        Called by `epd_init`.
+ *
+ * @note Text drawn without a framebuffer goes to the panel in bands of
+ *       `EPD_TEXT_BUFFER_ROWS` rows, 64 by default, so its buffer takes the
+ *       screen width times that many rows.
+ */
+void epd_font_init();
+
 /**
  * @brief Get the text bounds for string, when drawn at (x, y).
  *        Set font properties to NULL to use the defaults.
@@ -371,14 +585,44 @@ void writeln(const GFXfont *font, const char *string, int32_t *cursor_x,
 /**
  * @brief Write text to the EPD.
  *
- * @note If framebuffer is NULL, draw mode `mode` is used for direct drawing.
+ * @note If framebuffer is NULL, draw mode `mode` is used for direct drawing
+ *       of the part of the text on the screen.
  */
 void write_mode(const GFXfont *font, const char *string, int32_t *cursor_x,
                 int32_t *cursor_y, uint8_t *framebuffer, DrawMode_t mode,
                 const FontProperties *properties);
 
 /**
- * @brief Get the font glyph for a unicode code point.
+ * @brief Decode a string once and lay it out in a font.
+ *
+ * @note `bounds` match what `get_text_bounds` reports for a cursor at (0, 0).
+ *       Of the properties only the fallback glyph and `DRAW_BACKGROUND`
+ *       affect the layout. Free the run with `free_glyph_run`.
+ *
+ * @return false if memory ran out.
+ */
+bool layout_text(const GFXfont *font, const char *string,
+                 const FontProperties *properties, GlyphRun *run);
+
+/**
+ * @brief Draw a glyph run with its base line starting at the cursor and move
+ *        the cursor past it, like `write_mode`.
+ */
+void write_glyph_run(const GlyphRun *run, int32_t *cursor_x, int32_t *cursor_y,
+                     uint8_t *framebuffer, DrawMode_t mode,
+                     const FontProperties *properties);
+
+/**
+ * @brief Free the glyphs of a run.
+ */
+void free_glyph_run(GlyphRun *run);
+
+/**
+ * @brief Get the font glyph for a unicode code point, NULL if the font has
+ *        none.
+ *
+ * @note Code points below `font->direct_count` are a table lookup, the others
+ *       a binary search over the intervals.
  */
 void get_glyph(const GFXfont *font, uint32_t code_point, GFXglyph **glyph);
 
@@ -0,0 +1,334 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_font_file.h"
+#include "epd_glyph_cache.h"
+#include "epd_text_cache.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+#define HEADER_SIZE 32
+#define INTERVAL_SIZE 12
+#define GLYPH_SIZE 16
+
+/**
+ * @brief Code points the loader builds a direct glyph index for.
+ */
+#define DIRECT_COUNT 256
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+struct FontFile
+{
+    FILE *fp;
+    uint32_t bitmap_start; /** File offset of the glyph bitmaps. */
+    uint32_t bitmap_size;
+    uint32_t glyph_count;
+};
+
+typedef struct
+{
+    const struct FontFile *file; /** NULL for a free page. */
+    uint32_t index;
+    uint32_t last_used;
+    uint32_t length;             /** Valid bytes, less than a page at the end of the file. */
+} FontPage_t;
+
+/******************************************************************************/
+/***        local function prototypes                                       ***/
+/******************************************************************************/
+
+static const uint8_t *get_page(struct FontFile *file, uint32_t index, uint32_t *length);
+
+static uint32_t read_u32(const uint8_t *p);
+
+static uint16_t read_u16(const uint8_t *p);
+
+static bool read_at(FILE *fp, uint32_t offset, void *dst, size_t len);
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+static FontPage_t pages[EPD_FONT_PAGE_COUNT];
+
+/**
+ * @brief Page data, `EPD_FONT_PAGE_SIZE` bytes per page, allocated by the
+ *        first font loaded.
+ */
+static uint8_t *page_data = NULL;
+
+static uint32_t use_clock = 0;
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+bool epd_font_load(const char *path, GFXfont *font)
+{
+    memset(font, 0, sizeof(GFXfont));
+
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        ESP_LOGE("font_file", "cannot open %s", path);
+        return false;
+    }
+
+    uint8_t raw[HEADER_SIZE];
+    if (!read_at(fp, 0, raw, HEADER_SIZE))
+    {
+        fclose(fp);
+        return false;
+    }
+    FontFileHeader_t header = {
+        .magic = read_u32(&raw[0]),
+        .version = read_u16(&raw[4]),
+        .flags = read_u16(&raw[6]),
+        .interval_count = read_u32(&raw[8]),
+        .glyph_count = read_u32(&raw[12]),
+        .bitmap_size = read_u32(&raw[16]),
+        .advance_y = (int32_t)read_u32(&raw[20]),
+        .ascender = (int32_t)read_u32(&raw[24]),
+        .descender = (int32_t)read_u32(&raw[28]),
+    };
+    // glyph indices must fit the direct index
+    if (header.magic != FONT_FILE_MAGIC || header.version != FONT_FILE_VERSION ||
+        header.glyph_count >= GLYPH_INDEX_NONE || header.interval_count > header.glyph_count)
+    {
+        ESP_LOGE("font_file", "%s is not a font file", path);
+        fclose(fp);
+        return false;
+    }
+
+    struct FontFile *file = (struct FontFile *)malloc(sizeof(struct FontFile));
+    UnicodeInterval *intervals = (UnicodeInterval *)malloc(header.interval_count * sizeof(UnicodeInterval));
+    GFXglyph *glyphs = (GFXglyph *)malloc(header.glyph_count * sizeof(GFXglyph));
+    uint16_t *direct_index = (uint16_t *)malloc(DIRECT_COUNT * sizeof(uint16_t));
+    uint8_t *table = (uint8_t *)malloc(header.glyph_count * GLYPH_SIZE + header.interval_count * INTERVAL_SIZE);
+    if (page_data == NULL)
+    {
+        page_data = (uint8_t *)heap_caps_malloc(EPD_FONT_PAGE_COUNT * EPD_FONT_PAGE_SIZE, MALLOC_CAP_SPIRAM);
+    }
+    bool ok = file != NULL && intervals != NULL && glyphs != NULL && direct_index != NULL && table != NULL &&
+              page_data != NULL;
+
+    uint32_t table_size = header.interval_count * INTERVAL_SIZE + header.glyph_count * GLYPH_SIZE;
+    ok = ok && read_at(fp, HEADER_SIZE, table, table_size);
+
+    // intervals must be ascending and index into the glyph table
+    for (uint32_t i = 0; ok && i < header.interval_count; i++)
+    {
+        const uint8_t *p = &table[i * INTERVAL_SIZE];
+        intervals[i].first = read_u32(&p[0]);
+        intervals[i].last = read_u32(&p[4]);
+        intervals[i].offset = read_u32(&p[8]);
+        ok = intervals[i].first <= intervals[i].last &&
+             (i == 0 || intervals[i].first > intervals[i - 1].last) &&
+             intervals[i].offset <= header.glyph_count &&
+             intervals[i].last - intervals[i].first < header.glyph_count - intervals[i].offset;
+    }
+
+    // glyph data must lie within the bitmaps
+    const uint8_t *glyph_table = &table[header.interval_count * INTERVAL_SIZE];
+    uint32_t largest = 0;
+    for (uint32_t i = 0; ok && i < header.glyph_count; i++)
+    {
+        const uint8_t *p = &glyph_table[i * GLYPH_SIZE];
+        glyphs[i].width = p[0];
+        glyphs[i].height = p[1];
+        glyphs[i].advance_x = p[2];
+        glyphs[i].left = (int16_t)read_u16(&p[4]);
+        glyphs[i].top = (int16_t)read_u16(&p[6]);
+        glyphs[i].compressed_size = read_u16(&p[8]);
+        glyphs[i].data_offset = read_u32(&p[12]);
+        ok = glyphs[i].data_offset <= header.bitmap_size &&
+             glyphs[i].compressed_size <= header.bitmap_size - glyphs[i].data_offset;
+        largest = glyphs[i].compressed_size > largest ? glyphs[i].compressed_size : largest;
+    }
+    free(table);
+
+    // compressed glyphs are read whole before they are decoded
+    bool compressed = header.flags & (FONT_FILE_COMPRESSED | FONT_FILE_RLE | FONT_FILE_DEFLATE);
+    ok = ok && (!compressed || epd_glyph_cache_reserve(largest));
+
+    if (!ok)
+    {
+        ESP_LOGE("font_file", "cannot load %s", path);
+        free(file);
+        free(intervals);
+        free(glyphs);
+        free(direct_index);
+        fclose(fp);
+        return false;
+    }
+
+    file->fp = fp;
+    file->bitmap_start = HEADER_SIZE + table_size;
+    file->bitmap_size = header.bitmap_size;
+    file->glyph_count = header.glyph_count;
+
+    font->bitmap = NULL;
+    font->glyph = glyphs;
+    font->intervals = intervals;
+    font->interval_count = header.interval_count;
+    font->compressed = header.flags & FONT_FILE_RLE          ? GLYPH_CODEC_RLE
+                       : header.flags & FONT_FILE_DEFLATE    ? GLYPH_CODEC_DEFLATE
+                       : header.flags & FONT_FILE_COMPRESSED ? GLYPH_CODEC_ZLIB
+                                                             : GLYPH_CODEC_NONE;
+    font->advance_y = header.advance_y;
+    font->ascender = header.ascender;
+    font->descender = header.descender;
+    font->file = file;
+
+    // get_glyph searches the intervals until the direct index is set
+    for (uint32_t cp = 0; cp < DIRECT_COUNT; cp++)
+    {
+        GFXglyph *glyph;
+        get_glyph(font, cp, &glyph);
+        direct_index[cp] = glyph != NULL ? glyph - glyphs : GLYPH_INDEX_NONE;
+    }
+    font->direct_index = direct_index;
+    font->direct_count = DIRECT_COUNT;
+    return true;
+}
+
+
+void epd_font_unload(GFXfont *font)
+{
+    if (font->file == NULL)
+    {
+        return;
+    }
+
+    epd_glyph_cache_clear();
+    epd_text_cache_clear();
+    for (int32_t i = 0; i < EPD_FONT_PAGE_COUNT; i++)
+    {
+        if (pages[i].file == font->file)
+        {
+            pages[i].file = NULL;
+        }
+    }
+
+    fclose(font->file->fp);
+    free(font->file);
+    free(font->glyph);
+    free(font->intervals);
+    free((uint16_t *)font->direct_index);
+    memset(font, 0, sizeof(GFXfont));
+}
+
+
+size_t epd_font_memory(const GFXfont *font)
+{
+    if (font->file == NULL)
+    {
+        return 0;
+    }
+    return sizeof(struct FontFile) + font->file->glyph_count * sizeof(GFXglyph) +
+           font->interval_count * sizeof(UnicodeInterval) + font->direct_count * sizeof(uint16_t);
+}
+
+
+bool epd_font_read(struct FontFile *file, uint32_t offset, uint8_t *dst, size_t len)
+{
+    if (offset > file->bitmap_size || len > file->bitmap_size - offset)
+    {
+        return false;
+    }
+
+    while (len > 0)
+    {
+        uint32_t length;
+        const uint8_t *page = get_page(file, offset / EPD_FONT_PAGE_SIZE, &length);
+        uint32_t start = offset % EPD_FONT_PAGE_SIZE;
+        if (page == NULL || start >= length)
+        {
+            return false;
+        }
+        size_t chunk = length - start < len ? length - start : len;
+        memcpy(dst, &page[start], chunk);
+        dst += chunk;
+        offset += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+static const uint8_t *get_page(struct FontFile *file, uint32_t index, uint32_t *length)
+{
+    int32_t victim = 0;
+    for (int32_t i = 0; i < EPD_FONT_PAGE_COUNT; i++)
+    {
+        if (pages[i].file == file && pages[i].index == index)
+        {
+            pages[i].last_used = ++use_clock;
+            *length = pages[i].length;
+            return &page_data[i * EPD_FONT_PAGE_SIZE];
+        }
+        if (pages[i].file == NULL ||
+            (pages[victim].file != NULL && pages[i].last_used < pages[victim].last_used))
+        {
+            victim = i;
+        }
+    }
+
+    uint32_t offset = index * EPD_FONT_PAGE_SIZE;
+    uint32_t remaining = file->bitmap_size - offset;
+    uint32_t page_length = remaining < EPD_FONT_PAGE_SIZE ? remaining : EPD_FONT_PAGE_SIZE;
+    uint8_t *page = &page_data[victim * EPD_FONT_PAGE_SIZE];
+    pages[victim].file = NULL;
+    if (!read_at(file->fp, file->bitmap_start + offset, page, page_length))
+    {
+        return NULL;
+    }
+
+    pages[victim].file = file;
+    pages[victim].index = index;
+    pages[victim].last_used = ++use_clock;
+    pages[victim].length = page_length;
+    *length = page_length;
+    return page;
+}
+
+
+static uint32_t read_u32(const uint8_t *p)
+{
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+
+static uint16_t read_u16(const uint8_t *p)
+{
+    return p[0] | (uint16_t)(p[1] << 8);
+}
+
+
+static bool read_at(FILE *fp, uint32_t offset, void *dst, size_t len)
+{
+    return fseek(fp, offset, SEEK_SET) == 0 && fread(dst, 1, len, fp) == len;
+}
+
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -0,0 +1,137 @@
+/**
+ * Fonts loaded from a file: the glyph index is read into RAM, glyph bitmaps
+ * are paged in on demand through a small page cache.
+ *
+ * The file is little-endian, as written by `scripts/fontconvert.py --binary`:
+ *
+ *   header     32 bytes, see `FontFileHeader_t`
+ *   intervals  12 bytes each: first, last, offset (uint32)
+ *   glyphs     16 bytes each: width, height, advance_x (uint8), reserved,
+ *              left, top (int16), compressed_size (uint16), reserved (uint16),
+ *              data_offset (uint32)
+ *   bitmaps    the glyph bitmaps, `data_offset` is relative to their start
+ */
+
+#ifndef _EPD_FONT_FILE_H_
+#define _EPD_FONT_FILE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_driver.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+#define FONT_FILE_MAGIC 0x46445045 /* "EPDF" */
+#define FONT_FILE_VERSION 1
+
+/**
+ * @brief Bytes read from a font file at a time.
+ */
+#ifndef EPD_FONT_PAGE_SIZE
+#define EPD_FONT_PAGE_SIZE 4096
+#endif
+
+/**
+ * @brief Pages kept in PSRAM, shared by all loaded fonts.
+ */
+#ifndef EPD_FONT_PAGE_COUNT
+#define EPD_FONT_PAGE_COUNT 8
+#endif
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/**
+ * @brief Flags of a font file.
+ */
+enum FontFileFlags
+{
+    FONT_FILE_COMPRESSED = 1 << 0, /** Glyph bitmaps are zlib streams. */
+    FONT_FILE_RLE        = 1 << 1, /** Glyph bitmaps are `GLYPH_CODEC_RLE` encoded. */
+    FONT_FILE_DEFLATE    = 1 << 2, /** Glyph bitmaps are raw deflate streams. */
+};
+
+/**
+ * @brief Header at the start of a font file.
+ */
+typedef struct
+{
+    uint32_t magic;          /** FONT_FILE_MAGIC */
+    uint16_t version;        /** FONT_FILE_VERSION */
+    uint16_t flags;          /** FontFileFlags */
+    uint32_t interval_count; /** Number of unicode intervals. */
+    uint32_t glyph_count;    /** Number of glyphs. */
+    uint32_t bitmap_size;    /** Bytes of glyph bitmaps. */
+    int32_t advance_y;       /** Newline distance (y axis) */
+    int32_t ascender;        /** Maximal height of a glyph above the base line */
+    int32_t descender;       /** Maximal height of a glyph below the base line */
+} FontFileHeader_t;
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/**
+ * @brief Load a font file into a `GFXfont` that draws like a compiled in one.
+ *
+ * @note Any path of the VFS works, e.g. the SD card at "/sd" or a flash
+ *       partition mounted with SPIFFS or LittleFS. The file stays open until
+ *       the font is unloaded.
+ *
+ * @param path The font file.
+ * @param font Receives the font.
+ *
+ * @return false if the file is missing, invalid or memory ran out.
+ */
+bool epd_font_load(const char *path, GFXfont *font);
+
+/**
+ * @brief Close the file of a loaded font and free its index.
+ *
+ * @note Clears the glyph and text caches, which refer to the font.
+ */
+void epd_font_unload(GFXfont *font);
+
+/**
+ * @brief Get the RAM a loaded font holds for its index, 0 for compiled in
+ *        fonts. Pages and cached glyphs are not included.
+ */
+size_t epd_font_memory(const GFXfont *font);
+
+/**
+ * @brief Read glyph bitmap bytes of a font file through the page cache.
+ *
+ * @param file   The font file, `GFXfont->file`.
+ * @param offset Offset into the glyph bitmaps.
+ * @param dst    Receives the bytes.
+ * @param len    Number of bytes.
+ *
+ * @return false on a read error or if the range is outside the bitmaps.
+ */
+bool epd_font_read(struct FontFile *file, uint32_t offset, uint8_t *dst, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
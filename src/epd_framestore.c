@@ -0,0 +1,179 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_framestore.h"
+#include "epd_rle.h"
+
+#include <esp_heap_caps.h>
+#include <string.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+#define ROW_BYTES (EPD_WIDTH / 2)
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/**
+ * @brief How a row is stored.
+ */
+typedef enum
+{
+    ROW_MISSING, /** Not stored, memory ran out. Compares as changed. */
+    ROW_RLE,     /** Run-length encoded. */
+    ROW_RAW,     /** Plain bytes, the encoding would not be smaller. */
+} RowKind_t;
+
+/******************************************************************************/
+/***        local function prototypes                                       ***/
+/******************************************************************************/
+
+/**
+ * @brief Compare a raw row segment by segment, as `epd_rle_diff` does.
+ */
+static uint32_t diff_raw(const uint8_t *stored, const uint8_t *row, int32_t segment_bytes);
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+/**
+ * @brief Encoded rows, back to back.
+ */
+static uint8_t *frame_data = NULL;
+static size_t frame_capacity = 0;
+
+/**
+ * @brief Start of each stored row in `frame_data`.
+ */
+static uint32_t row_offsets[EPD_HEIGHT];
+
+/**
+ * @brief RowKind_t of each row.
+ */
+static uint8_t row_kinds[EPD_HEIGHT];
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+bool epd_framestore_store(const uint8_t *framebuffer)
+{
+    // rows that don't compress, e.g. of dithered images, are kept raw
+    size_t size = 0;
+    for (int32_t y = 0; y < EPD_HEIGHT; y++)
+    {
+        size_t encoded = epd_rle_encode(&framebuffer[y * ROW_BYTES], ROW_BYTES, NULL);
+        row_offsets[y] = size;
+        row_kinds[y] = encoded < ROW_BYTES ? ROW_RLE : ROW_RAW;
+        size += encoded < ROW_BYTES ? encoded : ROW_BYTES;
+    }
+
+    // grow as needed, give memory back once the page became much simpler
+    if (size > frame_capacity || size < frame_capacity / 4)
+    {
+        uint8_t *data = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if (data != NULL)
+        {
+            heap_caps_free(frame_data);
+            frame_data = data;
+            frame_capacity = size;
+        }
+    }
+
+    // without a larger buffer, keep the rows that fit the old one
+    bool complete = true;
+    for (int32_t y = 0; y < EPD_HEIGHT; y++)
+    {
+        const uint8_t *row = &framebuffer[y * ROW_BYTES];
+        size_t end = y + 1 < EPD_HEIGHT ? row_offsets[y + 1] : size;
+        if (frame_data == NULL || end > frame_capacity)
+        {
+            row_kinds[y] = ROW_MISSING;
+            complete = false;
+        }
+        else if (row_kinds[y] == ROW_RLE)
+        {
+            epd_rle_encode(row, ROW_BYTES, &frame_data[row_offsets[y]]);
+        }
+        else
+        {
+            memcpy(&frame_data[row_offsets[y]], row, ROW_BYTES);
+        }
+    }
+    return complete;
+}
+
+
+bool epd_framestore_valid()
+{
+    return frame_data != NULL;
+}
+
+
+uint32_t epd_framestore_diff_row(int32_t y, const uint8_t *row, int32_t segment_bytes)
+{
+    if (frame_data == NULL || row_kinds[y] == ROW_MISSING)
+    {
+        return UINT32_MAX;
+    }
+    if (row_kinds[y] == ROW_RAW)
+    {
+        return diff_raw(&frame_data[row_offsets[y]], row, segment_bytes);
+    }
+    return epd_rle_diff(&frame_data[row_offsets[y]], row, ROW_BYTES, segment_bytes);
+}
+
+
+bool epd_framestore_get_row(int32_t y, uint8_t *row)
+{
+    if (frame_data == NULL || row_kinds[y] == ROW_MISSING)
+    {
+        return false;
+    }
+    if (row_kinds[y] == ROW_RAW)
+    {
+        memcpy(row, &frame_data[row_offsets[y]], ROW_BYTES);
+    }
+    else
+    {
+        epd_rle_decode(&frame_data[row_offsets[y]], row, ROW_BYTES);
+    }
+    return true;
+}
+
+
+size_t epd_framestore_size()
+{
+    return frame_capacity + sizeof(row_offsets) + sizeof(row_kinds);
+}
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+static uint32_t diff_raw(const uint8_t *stored, const uint8_t *row, int32_t segment_bytes)
+{
+    uint32_t changed = 0;
+    for (int32_t start = 0, segment = 0; start < ROW_BYTES; start += segment_bytes, segment++)
+    {
+        int32_t len = ROW_BYTES - start < segment_bytes ? ROW_BYTES - start : segment_bytes;
+        if (memcmp(&stored[start], &row[start], len) != 0)
+        {
+            changed |= 1u << segment;
+        }
+    }
+    return changed;
+}
+
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -0,0 +1,87 @@
+/**
+ * Run-length encoded copy of the frame last shown on the display, with row
+ * level random access.
+ */
+
+#ifndef _EPD_FRAMESTORE_H_
+#define _EPD_FRAMESTORE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_driver.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/**
+ * @brief Replace the stored frame with a framebuffer.
+ *
+ * @note Flat rows take a few bytes each, so a typical page needs a small
+ *       fraction of the `EPD_WIDTH / 2 * EPD_HEIGHT` bytes of the framebuffer.
+ *       Rows the encoding would not shrink are stored raw, so a frame never
+ *       takes more than the framebuffer.
+ *
+ * @return false if memory ran out. The rows that fit the previous buffer
+ *         are stored, the others compare as changed.
+ */
+bool epd_framestore_store(const uint8_t *framebuffer);
+
+/**
+ * @brief Check whether a frame is stored.
+ */
+bool epd_framestore_valid();
+
+/**
+ * @brief Compare a row of a framebuffer to the stored frame without decoding.
+ *
+ * @param y             The row.
+ * @param row           The framebuffer row, `EPD_WIDTH / 2` bytes.
+ * @param segment_bytes Width of a segment in bytes, at most 32 segments a row.
+ *
+ * @return One bit per segment that differs, all bits if nothing is stored.
+ */
+uint32_t epd_framestore_diff_row(int32_t y, const uint8_t *row, int32_t segment_bytes);
+
+/**
+ * @brief Decode one row of the stored frame.
+ *
+ * @return false if the row is not stored.
+ */
+bool epd_framestore_get_row(int32_t y, uint8_t *row);
+
+/**
+ * @brief Get the memory used by the stored frame in bytes.
+ */
+size_t epd_framestore_size();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
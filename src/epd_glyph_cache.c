@@ -0,0 +1,529 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_glyph_cache.h"
+#include "epd_font_file.h"
+#include "zlib/zlib.h"
+
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief Hash buckets, a power of two.
+ */
+#define BUCKET_COUNT 256
+
+#define NO_ENTRY -1
+
+/**
+ * @brief Bytes compaction frees beyond the glyph it makes room for, so the
+ *        arena is compacted once per quarter of it filled, not on every miss.
+ */
+#define COMPACT_SLACK (EPD_GLYPH_CACHE_BYTES / 4)
+
+/**
+ * @brief Window bits of raw deflate glyphs, the largest window zlib writes.
+ */
+#define RAW_WINDOW_BITS -15
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+typedef struct
+{
+    const GFXfont *font;
+    uint32_t index;   /** Glyph index in `font->glyph`. */
+    uint8_t *bitmap;
+    uint32_t size;
+    int16_t prev;     /** More recently used neighbour. */
+    int16_t next;     /** Less recently used neighbour. */
+    int16_t chain;    /** Next entry in the same bucket. */
+    int16_t below;    /** Entry placed before this one in the arena. */
+    int16_t above;    /** Entry placed after this one in the arena. */
+} GlyphCacheEntry_t;
+
+/******************************************************************************/
+/***        local function prototypes                                       ***/
+/******************************************************************************/
+
+static uint32_t bucket_of(const GFXfont *font, uint32_t index);
+
+static int16_t find_entry(const GFXfont *font, uint32_t index);
+
+static void lru_unlink(int16_t e);
+
+static void lru_push_front(int16_t e);
+
+static void evict(int16_t e);
+
+/**
+ * @brief Get arena room for a glyph of `size` bytes, evicting and compacting
+ *        the cached glyphs as needed.
+ */
+static uint8_t *place(uint32_t size);
+
+/**
+ * @brief Move the cached glyphs to the start of the arena, in arena order.
+ */
+static void compact();
+
+static uint8_t *load_glyph(const GFXfont *font, const GFXglyph *glyph, uint8_t *bitmap, uint32_t size);
+
+/**
+ * @brief Decode a `GLYPH_CODEC_RLE` bitmap, as written by
+ *        `scripts/fontconvert.py --codec rle`.
+ *
+ * The data is a stream of nibbles, low nibble first. Each token is two
+ * nibbles, bit 7 selects a run of 0x0 or 0xF pixels, bits 6-2 are its length
+ * (0 to 31) and bits 1-0 the number of literal pixels (0 to 3) that follow
+ * the token.
+ *
+ * @return false if the data is corrupt.
+ */
+static bool rle_decode(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size);
+
+/**
+ * @brief Inflate a zlib or, with negative `window_bits`, raw deflate glyph
+ *        with the shared inflate state.
+ */
+static bool inflate_glyph(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size,
+                          int window_bits);
+
+static inline uint8_t nibble_at(const uint8_t *buf, uint32_t pos);
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+static GlyphCacheEntry_t entries[EPD_GLYPH_CACHE_ENTRIES];
+static int16_t buckets[BUCKET_COUNT];
+static int16_t free_list = NO_ENTRY;
+static bool initialized = false;
+
+/**
+ * @brief Most and least recently used entries.
+ */
+static int16_t lru_head = NO_ENTRY;
+static int16_t lru_tail = NO_ENTRY;
+
+/**
+ * @brief Lowest and highest placed entries, the arena is filled upward from
+ *        the lowest and compacted when a glyph does not fit above the highest.
+ */
+static int16_t arena_first = NO_ENTRY;
+static int16_t arena_last = NO_ENTRY;
+
+static GlyphCacheStats_t stats;
+
+/**
+ * @brief Holds the cached bitmaps, allocated once by `epd_glyph_cache_init`.
+ */
+static uint8_t *arena = NULL;
+
+/**
+ * @brief Returned for glyphs without pixels of fonts loaded from a file.
+ */
+static const uint8_t blank_bitmap[1] = {0};
+
+/**
+ * @brief Inflate state reset for every glyph instead of allocated per glyph,
+ *        set up by `epd_glyph_cache_init`.
+ */
+static z_stream inflater;
+static bool inflater_ready = false;
+
+/**
+ * @brief Holds the compressed bytes of a glyph read from a font file, grown
+ *        by `epd_glyph_cache_reserve` to the largest glyph of a loaded font.
+ */
+static uint8_t *packed = NULL;
+static uint32_t packed_size = 0;
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+const uint8_t *epd_glyph_cache_get(const GFXfont *font, const GFXglyph *glyph)
+{
+    // blank glyphs such as the space have no pixels to load
+    if (glyph->width == 0 || glyph->height == 0)
+    {
+        return font->file != NULL ? blank_bitmap : &font->bitmap[glyph->data_offset];
+    }
+    if (font->compressed == GLYPH_CODEC_NONE && font->file == NULL)
+    {
+        return &font->bitmap[glyph->data_offset];
+    }
+    if (!initialized)
+    {
+        epd_glyph_cache_clear();
+    }
+
+    uint32_t index = glyph - font->glyph;
+    int16_t e = find_entry(font, index);
+    if (e != NO_ENTRY)
+    {
+        stats.hits++;
+        if (e != lru_head)
+        {
+            lru_unlink(e);
+            lru_push_front(e);
+        }
+        return entries[e].bitmap;
+    }
+
+    stats.misses++;
+    uint32_t size = (glyph->width / 2 + glyph->width % 2) * glyph->height;
+    if (arena == NULL)
+    {
+        epd_glyph_cache_init();
+    }
+    if (arena == NULL || size > EPD_GLYPH_CACHE_BYTES)
+    {
+        return NULL;
+    }
+
+    // a failed load leaves the room unused, the next glyph is placed there
+    uint8_t *bitmap = place(size);
+    if (load_glyph(font, glyph, bitmap, size) == NULL)
+    {
+        return NULL;
+    }
+
+    e = free_list;
+    free_list = entries[e].chain;
+    entries[e].font = font;
+    entries[e].index = index;
+    entries[e].bitmap = bitmap;
+    entries[e].size = size;
+    entries[e].below = arena_last;
+    entries[e].above = NO_ENTRY;
+    if (arena_last != NO_ENTRY)
+        entries[arena_last].above = e;
+    else
+        arena_first = e;
+    arena_last = e;
+    uint32_t bucket = bucket_of(font, index);
+    entries[e].chain = buckets[bucket];
+    buckets[bucket] = e;
+    lru_push_front(e);
+    stats.bytes += size;
+    stats.entries++;
+    return bitmap;
+}
+
+
+bool epd_glyph_cache_init()
+{
+    if (arena == NULL)
+    {
+        arena = (uint8_t *)heap_caps_malloc(EPD_GLYPH_CACHE_BYTES, MALLOC_CAP_SPIRAM);
+    }
+    if (!inflater_ready)
+    {
+        // inflate_glyph resets the window bits for every glyph
+        memset(&inflater, 0, sizeof(inflater));
+        inflater_ready = inflateInit2(&inflater, MAX_WBITS) == Z_OK;
+    }
+    if (!initialized)
+    {
+        epd_glyph_cache_clear();
+    }
+    return arena != NULL && inflater_ready;
+}
+
+
+bool epd_glyph_cache_reserve(uint32_t compressed_size)
+{
+    if (compressed_size > packed_size)
+    {
+        free(packed);
+        packed = (uint8_t *)malloc(compressed_size);
+        packed_size = packed != NULL ? compressed_size : 0;
+    }
+    return packed != NULL || compressed_size == 0;
+}
+
+
+void epd_glyph_cache_clear()
+{
+    for (int32_t b = 0; b < BUCKET_COUNT; b++)
+    {
+        buckets[b] = NO_ENTRY;
+    }
+    for (int32_t e = 0; e < EPD_GLYPH_CACHE_ENTRIES; e++)
+    {
+        entries[e].bitmap = NULL;
+        entries[e].chain = e + 1 < EPD_GLYPH_CACHE_ENTRIES ? e + 1 : NO_ENTRY;
+    }
+    free_list = 0;
+    lru_head = NO_ENTRY;
+    lru_tail = NO_ENTRY;
+    arena_first = NO_ENTRY;
+    arena_last = NO_ENTRY;
+    memset(&stats, 0, sizeof(stats));
+    initialized = true;
+}
+
+
+void epd_glyph_cache_get_stats(GlyphCacheStats_t *out)
+{
+    *out = stats;
+}
+
+
+size_t epd_glyph_cache_font_bytes(const GFXfont *font)
+{
+    size_t bytes = 0;
+    for (int16_t e = lru_head; initialized && e != NO_ENTRY; e = entries[e].next)
+    {
+        if (entries[e].font == font)
+        {
+            bytes += entries[e].size;
+        }
+    }
+    return bytes;
+}
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+static uint32_t bucket_of(const GFXfont *font, uint32_t index)
+{
+    uint32_t key = (uint32_t)(uintptr_t)font ^ (index * 2654435761u);
+    return (key ^ (key >> 16)) & (BUCKET_COUNT - 1);
+}
+
+
+static int16_t find_entry(const GFXfont *font, uint32_t index)
+{
+    for (int16_t e = buckets[bucket_of(font, index)]; e != NO_ENTRY; e = entries[e].chain)
+    {
+        if (entries[e].index == index && entries[e].font == font)
+        {
+            return e;
+        }
+    }
+    return NO_ENTRY;
+}
+
+
+static void lru_unlink(int16_t e)
+{
+    if (entries[e].prev != NO_ENTRY)
+        entries[entries[e].prev].next = entries[e].next;
+    else
+        lru_head = entries[e].next;
+
+    if (entries[e].next != NO_ENTRY)
+        entries[entries[e].next].prev = entries[e].prev;
+    else
+        lru_tail = entries[e].prev;
+}
+
+
+static void lru_push_front(int16_t e)
+{
+    entries[e].prev = NO_ENTRY;
+    entries[e].next = lru_head;
+    if (lru_head != NO_ENTRY)
+        entries[lru_head].prev = e;
+    else
+        lru_tail = e;
+    lru_head = e;
+}
+
+
+static void evict(int16_t e)
+{
+    int16_t *link = &buckets[bucket_of(entries[e].font, entries[e].index)];
+    while (*link != e)
+    {
+        link = &entries[*link].chain;
+    }
+    *link = entries[e].chain;
+
+    lru_unlink(e);
+    if (entries[e].below != NO_ENTRY)
+        entries[entries[e].below].above = entries[e].above;
+    else
+        arena_first = entries[e].above;
+
+    if (entries[e].above != NO_ENTRY)
+        entries[entries[e].above].below = entries[e].below;
+    else
+        arena_last = entries[e].below;
+
+    entries[e].bitmap = NULL;
+    entries[e].chain = free_list;
+    free_list = e;
+
+    stats.bytes -= entries[e].size;
+    stats.entries--;
+    stats.evictions++;
+}
+
+
+static uint8_t *place(uint32_t size)
+{
+    while (lru_tail != NO_ENTRY && (free_list == NO_ENTRY || stats.bytes + size > EPD_GLYPH_CACHE_BYTES))
+    {
+        evict(lru_tail);
+    }
+
+    uint32_t top = arena_last != NO_ENTRY ? entries[arena_last].bitmap + entries[arena_last].size - arena : 0;
+    if (top + size > EPD_GLYPH_CACHE_BYTES)
+    {
+        while (lru_tail != NO_ENTRY && stats.bytes + size + COMPACT_SLACK > EPD_GLYPH_CACHE_BYTES)
+        {
+            evict(lru_tail);
+        }
+        compact();
+        top = stats.bytes;
+    }
+    return &arena[top];
+}
+
+
+static void compact()
+{
+    uint8_t *top = arena;
+    for (int16_t e = arena_first; e != NO_ENTRY; e = entries[e].above)
+    {
+        if (entries[e].bitmap != top)
+        {
+            memmove(top, entries[e].bitmap, entries[e].size);
+            entries[e].bitmap = top;
+        }
+        top += entries[e].size;
+    }
+}
+
+
+static uint8_t *load_glyph(const GFXfont *font, const GFXglyph *glyph, uint8_t *bitmap, uint32_t size)
+{
+    if (font->compressed == GLYPH_CODEC_NONE)
+    {
+        return epd_font_read(font->file, glyph->data_offset, bitmap, size) ? bitmap : NULL;
+    }
+
+    const uint8_t *data = &font->bitmap[glyph->data_offset];
+    if (font->file != NULL)
+    {
+        if (glyph->compressed_size > packed_size || !epd_font_read(font->file, glyph->data_offset, packed, glyph->compressed_size))
+        {
+            return NULL;
+        }
+        data = packed;
+    }
+
+    bool ok;
+    switch (font->compressed)
+    {
+    case GLYPH_CODEC_RLE:
+        ok = rle_decode(data, glyph->compressed_size, bitmap, size);
+        break;
+    case GLYPH_CODEC_DEFLATE:
+        ok = inflate_glyph(data, glyph->compressed_size, bitmap, size, RAW_WINDOW_BITS);
+        break;
+    default:
+        ok = inflate_glyph(data, glyph->compressed_size, bitmap, size, MAX_WBITS);
+        break;
+    }
+    return ok ? bitmap : NULL;
+}
+
+
+static bool inflate_glyph(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size,
+                          int window_bits)
+{
+    if (!inflater_ready || inflateReset2(&inflater, window_bits) != Z_OK)
+    {
+        return false;
+    }
+
+    // with the whole glyph in one output buffer and Z_FINISH, inflate reads
+    // back references from the output and never allocates a window
+    inflater.next_in = (z_const Bytef *)src;
+    inflater.avail_in = src_size;
+    inflater.next_out = dst;
+    inflater.avail_out = dst_size;
+    return inflate(&inflater, Z_FINISH) == Z_STREAM_END;
+}
+
+
+static bool rle_decode(const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size)
+{
+    // positions in nibbles
+    uint32_t in = 0;
+    uint32_t in_end = src_size * 2;
+    uint32_t out = 0;
+    uint32_t out_end = dst_size * 2;
+
+    while (out < out_end)
+    {
+        if (in_end - in < 2)
+        {
+            return false;
+        }
+        uint8_t token = (in & 1) ? nibble_at(src, in) | nibble_at(src, in + 1) << 4 : src[in / 2];
+        in += 2;
+        uint32_t run = (token >> 2) & 0x1F;
+        uint32_t literals = token & 0x03;
+        if (run + literals > out_end - out || literals > in_end - in)
+        {
+            return false;
+        }
+
+        uint8_t fill = token & 0x80 ? 0x0F : 0x00;
+        if (run > 0 && (out & 1))
+        {
+            dst[out / 2] |= fill << 4;
+            out++;
+            run--;
+        }
+        memset(&dst[out / 2], fill * 0x11, run / 2);
+        out += run & ~1u;
+        if (run & 1)
+        {
+            dst[out / 2] = fill;
+            out++;
+        }
+
+        for (uint32_t i = 0; i < literals; i++, in++, out++)
+        {
+            uint8_t value = nibble_at(src, in);
+            if (out & 1)
+            {
+                dst[out / 2] |= value << 4;
+            }
+            else
+            {
+                dst[out / 2] = value;
+            }
+        }
+    }
+    return true;
+}
+
+
+static inline uint8_t nibble_at(const uint8_t *buf, uint32_t pos)
+{
+    return (buf[pos / 2] >> ((pos & 1) * 4)) & 0x0F;
+}
+
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -0,0 +1,125 @@
+/**
+ * Bounded cache of decompressed glyph bitmaps, least recently used glyphs are
+ * evicted first.
+ */
+
+#ifndef _EPD_GLYPH_CACHE_H_
+#define _EPD_GLYPH_CACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_driver.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief Bytes of bitmap data the cache may hold, allocated from PSRAM at
+ *        init. A FiraSans glyph is 400 bytes on average, a 32 KB budget holds
+ *        the glyphs of several pages of text. Larger glyphs are not drawn.
+ */
+#ifndef EPD_GLYPH_CACHE_BYTES
+#define EPD_GLYPH_CACHE_BYTES (32 * 1024)
+#endif
+
+/**
+ * @brief Maximum number of cached glyphs.
+ */
+#ifndef EPD_GLYPH_CACHE_ENTRIES
+#define EPD_GLYPH_CACHE_ENTRIES 256
+#endif
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/**
+ * @brief Cache counters since start or the last `epd_glyph_cache_clear`.
+ */
+typedef struct
+{
+    uint32_t hits;      /** Lookups answered from the cache. */
+    uint32_t misses;    /** Lookups that decompressed the glyph. */
+    uint32_t evictions; /** Glyphs dropped to make room. */
+    size_t bytes;       /** Bitmap bytes currently cached. */
+    int32_t entries;    /** Glyphs currently cached. */
+} GlyphCacheStats_t;
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/**
+ * @brief Get the bitmap of a glyph, decompressing it on a miss.
+ *
+ * @note Glyphs are keyed by font and glyph, i.e. by font and code point.
+ *       Uncompressed fonts in memory return their bitmap directly and bypass
+ *       the cache, fonts loaded from a file page their glyphs in on a miss.
+ *
+ * @note The returned bitmap is valid until the next call, a later miss may
+ *       evict it. Not thread safe, draw text from one task.
+ *
+ * @param font  The font the glyph belongs to.
+ * @param glyph A glyph of `font`.
+ *
+ * @return The 4 bit bitmap, `(width + 1) / 2` bytes per row, or NULL if
+ *         the cache could not be allocated, the glyph is larger than
+ *         `EPD_GLYPH_CACHE_BYTES` or its data is corrupt.
+ */
+const uint8_t *epd_glyph_cache_get(const GFXfont *font, const GFXglyph *glyph);
+
+/**
+ * @brief Allocate the cache and the inflate state, so drawing text does not
+ *        touch the heap. Called by `epd_init`, else by the first miss.
+ *
+ * @return false if memory ran out.
+ */
+bool epd_glyph_cache_init();
+
+/**
+ * @brief Make room for the compressed bytes of a glyph read from a font file.
+ *        Called by `epd_font_load` with the largest glyph of the font.
+ *
+ * @return false if memory ran out.
+ */
+bool epd_glyph_cache_reserve(uint32_t compressed_size);
+
+/**
+ * @brief Drop all cached glyphs and reset the counters, e.g. before a font is
+ *        unloaded.
+ */
+void epd_glyph_cache_clear();
+
+/**
+ * @brief Get the cache counters.
+ */
+void epd_glyph_cache_get_stats(GlyphCacheStats_t *stats);
+
+/**
+ * @brief Get the bytes of cached glyphs of one font.
+ */
+size_t epd_glyph_cache_font_bytes(const GFXfont *font);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -0,0 +1,157 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_planner.h"
+#include "epd_tiles.h"
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief `epd_push_pixels` calls in one flash cycle, four dark and four light.
+ */
+#define PUSHES_PER_CYCLE 8
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local function prototypes                                       ***/
+/******************************************************************************/
+
+static int32_t count_rows(Rect_t area, int32_t clear_cycles);
+
+static uint32_t pass_cost(const PlannedPass_t *pass, int32_t clear_cycles);
+
+static void make_pass(Rect_t area, int32_t covered, int32_t clear_cycles, PlannedPass_t *pass);
+
+static Rect_t rect_union(Rect_t a, Rect_t b);
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+void epd_plan_update(const DamageList_t *damage, int32_t clear_cycles, UpdatePlan_t *plan)
+{
+    plan->count = 0;
+    for (int32_t i = 0; i < damage->count; i++)
+    {
+        Rect_t area = damage->rects[i];
+        make_pass(area, area.width * area.height, clear_cycles, &plan->passes[plan->count++]);
+    }
+
+    // Merge the pair that saves the most until no merge saves anything
+    while (plan->count > 1)
+    {
+        int32_t best_i = -1;
+        int32_t best_j = -1;
+        int64_t best_saving = 0;
+        PlannedPass_t best_pass;
+        for (int32_t i = 0; i < plan->count; i++)
+        {
+            for (int32_t j = i + 1; j < plan->count; j++)
+            {
+                const PlannedPass_t *a = &plan->passes[i];
+                const PlannedPass_t *b = &plan->passes[j];
+                PlannedPass_t merged;
+                make_pass(rect_union(a->area, b->area), a->covered + b->covered, clear_cycles, &merged);
+                int64_t saving = (int64_t)a->cost_us + b->cost_us - merged.cost_us;
+                if (saving > best_saving)
+                {
+                    best_saving = saving;
+                    best_i = i;
+                    best_j = j;
+                    best_pass = merged;
+                }
+            }
+        }
+        if (best_i < 0)
+        {
+            break;
+        }
+        plan->passes[best_i] = best_pass;
+        plan->passes[best_j] = plan->passes[--plan->count];
+    }
+
+    plan->cost_us = 0;
+    for (int32_t i = 0; i < plan->count; i++)
+    {
+        plan->cost_us += plan->passes[i].cost_us;
+    }
+}
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+static int32_t count_rows(Rect_t area, int32_t clear_cycles)
+{
+    if (clear_cycles > 0)
+    {
+        return area.height;
+    }
+
+    uint8_t row_mask[(EPD_HEIGHT + 7) / 8];
+    epd_tiles_row_mask(area, row_mask);
+    int32_t rows = 0;
+    for (int32_t b = 0; b < (area.height + 7) / 8; b++)
+    {
+        rows += __builtin_popcount(row_mask[b]);
+    }
+    return rows;
+}
+
+
+static uint32_t pass_cost(const PlannedPass_t *pass, int32_t clear_cycles)
+{
+    // Driving displayed pixels again darkens them, weigh that like time
+    int32_t overdraw = pass->area.width * pass->area.height - pass->covered;
+    uint32_t penalty = overdraw > 0 ? overdraw / EPD_PLAN_OVERDRAW_PIXELS_PER_US : 0;
+
+    if (clear_cycles > 0)
+    {
+        return clear_cycles * PUSHES_PER_CYCLE *
+                   (EPD_PLAN_PUSH_US + pass->rows * EPD_PLAN_PUSH_ROW_US) +
+               penalty;
+    }
+    if (pass->rows == 0)
+    {
+        return 0;
+    }
+    return EPD_PLAN_PASS_US + pass->rows * EPD_PLAN_ROW_US + penalty;
+}
+
+
+static void make_pass(Rect_t area, int32_t covered, int32_t clear_cycles, PlannedPass_t *pass)
+{
+    pass->area = area;
+    pass->rows = count_rows(area, clear_cycles);
+    pass->covered = covered;
+    pass->cost_us = pass_cost(pass, clear_cycles);
+}
+
+
+static Rect_t rect_union(Rect_t a, Rect_t b)
+{
+    int32_t x0 = a.x < b.x ? a.x : b.x;
+    int32_t y0 = a.y < b.y ? a.y : b.y;
+    int32_t x1 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+    int32_t y1 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+    Rect_t u = {.x = x0, .y = y0, .width = x1 - x0, .height = y1 - y0};
+    return u;
+}
+
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -0,0 +1,121 @@
+/**
+ * Update planning: decides how damaged rectangles are grouped into display
+ * passes, based on an estimate of what each pass costs on the panel.
+ */
+
+#ifndef _EPD_PLANNER_H_
+#define _EPD_PLANNER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_damage.h"
+#include "epd_driver.h"
+
+#include <stdint.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief Fixed cost of an image draw in microseconds: 15 frames, each with
+ *        task setup and a scan over every panel row.
+ */
+#ifndef EPD_PLAN_PASS_US
+#define EPD_PLAN_PASS_US 100000
+#endif
+
+/**
+ * @brief Cost of writing one row in an image draw, over all 15 frames.
+ */
+#ifndef EPD_PLAN_ROW_US
+#define EPD_PLAN_ROW_US 500
+#endif
+
+/**
+ * @brief Fixed cost of one `epd_push_pixels` call, a scan over every row.
+ */
+#ifndef EPD_PLAN_PUSH_US
+#define EPD_PLAN_PUSH_US 6000
+#endif
+
+/**
+ * @brief Cost of one row pushed by `epd_push_pixels`.
+ */
+#ifndef EPD_PLAN_PUSH_ROW_US
+#define EPD_PLAN_PUSH_ROW_US 50
+#endif
+
+/**
+ * @brief Pixels outside the damage that a merged pass may drive again per
+ *        microsecond it saves. Driving a pixel again darkens it a little.
+ */
+#ifndef EPD_PLAN_OVERDRAW_PIXELS_PER_US
+#define EPD_PLAN_OVERDRAW_PIXELS_PER_US 4
+#endif
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/**
+ * @brief One draw or flash of an area.
+ */
+typedef struct
+{
+    Rect_t area;      /** The area driven by the pass. */
+    int32_t rows;     /** Rows written, the others are skipped. */
+    int32_t covered;  /** Damaged pixels in the area, the rest is overdraw. */
+    uint32_t cost_us; /** Estimated duration in microseconds. */
+} PlannedPass_t;
+
+/**
+ * @brief The passes an update is split into.
+ */
+typedef struct
+{
+    PlannedPass_t passes[EPD_DAMAGE_MAX_RECTS];
+    int32_t count;
+    uint32_t cost_us; /** Estimated duration of all passes. */
+} UpdatePlan_t;
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/**
+ * @brief Group damaged rectangles into passes.
+ *
+ * @note Every image draw scans all panel rows in each of its frames, so a
+ *       pass has a large fixed cost and merging usually pays off. Rects are
+ *       merged pairwise for as long as the merged pass, including its
+ *       overdraw, is cheaper than the two separate ones.
+ *
+ * @note Draw passes only write rows that `epd_tiles_row_mask` selects, call
+ *       after `epd_tiles_find_changed`.
+ *
+ * @param damage       The damaged rectangles.
+ * @param clear_cycles 0 to plan image draws, otherwise the number of flash
+ *                     cycles of `epd_push_pixels` pairs to plan for.
+ * @param plan         Receives the passes.
+ */
+void epd_plan_update(const DamageList_t *damage, int32_t clear_cycles, UpdatePlan_t *plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -0,0 +1,151 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_rle.h"
+
+#include <string.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief Longest literal and repeat run of one packet.
+ */
+#define MAX_LITERAL 128
+#define MAX_REPEAT 129
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local function prototypes                                       ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+size_t epd_rle_encode(const uint8_t *src, int32_t len, uint8_t *dst)
+{
+    size_t out = 0;
+    int32_t i = 0;
+    while (i < len)
+    {
+        int32_t run = 1;
+        while (i + run < len && run < MAX_REPEAT && src[i + run] == src[i])
+        {
+            run++;
+        }
+        if (run >= 2)
+        {
+            if (dst)
+            {
+                dst[out] = run + 126;
+                dst[out + 1] = src[i];
+            }
+            out += 2;
+            i += run;
+            continue;
+        }
+
+        // collect literals until the next repeat starts
+        int32_t start = i++;
+        while (i < len && i - start < MAX_LITERAL && !(i + 1 < len && src[i] == src[i + 1]))
+        {
+            i++;
+        }
+        int32_t count = i - start;
+        if (dst)
+        {
+            dst[out] = count - 1;
+            memcpy(&dst[out + 1], &src[start], count);
+        }
+        out += 1 + count;
+    }
+    return out;
+}
+
+
+const uint8_t *epd_rle_decode(const uint8_t *src, uint8_t *dst, int32_t len)
+{
+    int32_t i = 0;
+    while (i < len)
+    {
+        uint8_t header = *src++;
+        if (header < 128)
+        {
+            int32_t count = header + 1;
+            memcpy(&dst[i], src, count);
+            src += count;
+            i += count;
+        }
+        else
+        {
+            int32_t count = header - 126;
+            memset(&dst[i], *src++, count);
+            i += count;
+        }
+    }
+    return src;
+}
+
+
+
+uint32_t epd_rle_diff(const uint8_t *src, const uint8_t *row, int32_t len, int32_t segment_bytes)
+{
+    uint32_t mask = 0;
+    int32_t pos = 0;
+    int32_t skip = 0;
+    while (pos < len)
+    {
+        uint8_t header = *src++;
+        int32_t end;
+        const uint8_t *literals = NULL;
+        uint8_t value = 0;
+        if (header < 128)
+        {
+            end = pos + header + 1;
+            literals = src;
+            src += header + 1;
+        }
+        else
+        {
+            end = pos + header - 126;
+            value = *src++;
+        }
+
+        for (int32_t i = pos > skip ? pos : skip; i < end; i++)
+        {
+            uint8_t expected = literals ? literals[i - pos] : value;
+            if (row[i] != expected)
+            {
+                // the segment differs, no need to look at the rest of it
+                int32_t segment = i / segment_bytes;
+                mask |= 1u << segment;
+                skip = (segment + 1) * segment_bytes;
+                i = skip - 1;
+            }
+        }
+        pos = end;
+    }
+    return mask;
+}
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
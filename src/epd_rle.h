@@ -0,0 +1,76 @@
+/**
+ * PackBits style run-length coding of framebuffer rows.
+ */
+
+#ifndef _EPD_RLE_H_
+#define _EPD_RLE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/**
+ * @brief Encode a row of bytes.
+ *
+ * @note Header bytes below 128 are followed by `header + 1` literal bytes,
+ *       others by a single byte repeated `header - 126` times. Packets never
+ *       span rows.
+ *
+ * @param src The row.
+ * @param len Length of the row in bytes.
+ * @param dst Output, NULL to only compute the encoded size.
+ *
+ * @return The encoded size in bytes.
+ */
+size_t epd_rle_encode(const uint8_t *src, int32_t len, uint8_t *dst);
+
+/**
+ * @brief Decode a row of `len` bytes.
+ *
+ * @return The start of the next encoded row.
+ */
+const uint8_t *epd_rle_decode(const uint8_t *src, uint8_t *dst, int32_t len);
+
+/**
+ * @brief Compare an encoded row to a plain one without decoding it.
+ *
+ * @param src           The encoded row.
+ * @param row           The plain row, `len` bytes.
+ * @param len           Length of the row in bytes.
+ * @param segment_bytes Width of a segment in bytes, at most 32 segments.
+ *
+ * @return One bit per segment of `segment_bytes` bytes that differs.
+ */
+uint32_t epd_rle_diff(const uint8_t *src, const uint8_t *row, int32_t len, int32_t segment_bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -0,0 +1,120 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_saveunder.h"
+#include "epd_damage.h"
+#include "epd_rle.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local function prototypes                                       ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+bool epd_save_region(Rect_t area, const uint8_t *framebuffer, SavedRegion_t *region)
+{
+    region->data = NULL;
+    region->size = 0;
+
+    int32_t x0 = area.x < 0 ? 0 : area.x;
+    int32_t y0 = area.y < 0 ? 0 : area.y;
+    int32_t x1 = area.x + area.width;
+    int32_t y1 = area.y + area.height;
+    if (x1 > EPD_WIDTH)
+        x1 = EPD_WIDTH;
+    if (y1 > EPD_HEIGHT)
+        y1 = EPD_HEIGHT;
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return false;
+    }
+
+    // two pixels share a byte, save whole bytes
+    x0 &= ~1;
+    x1 = (x1 + 1) & ~1;
+    region->area.x = x0;
+    region->area.y = y0;
+    region->area.width = x1 - x0;
+    region->area.height = y1 - y0;
+
+    int32_t row_bytes = region->area.width / 2;
+    const uint8_t *src = &framebuffer[y0 * EPD_WIDTH / 2 + x0 / 2];
+
+    size_t size = 0;
+    for (int32_t y = 0; y < region->area.height; y++)
+    {
+        size += epd_rle_encode(src + y * EPD_WIDTH / 2, row_bytes, NULL);
+    }
+
+    uint8_t *data = (uint8_t *)malloc(size);
+    if (data == NULL)
+    {
+        return false;
+    }
+
+    size_t pos = 0;
+    for (int32_t y = 0; y < region->area.height; y++)
+    {
+        pos += epd_rle_encode(src + y * EPD_WIDTH / 2, row_bytes, data + pos);
+    }
+
+    region->data = data;
+    region->size = size;
+    return true;
+}
+
+
+void epd_restore_region(const SavedRegion_t *region, uint8_t *framebuffer)
+{
+    if (region->data == NULL)
+    {
+        return;
+    }
+
+    Rect_t area = region->area;
+    uint8_t *dst = &framebuffer[area.y * EPD_WIDTH / 2 + area.x / 2];
+    const uint8_t *src = region->data;
+    for (int32_t y = 0; y < area.height; y++)
+    {
+        src = epd_rle_decode(src, dst + y * EPD_WIDTH / 2, area.width / 2);
+    }
+    epd_damage_add(area);
+}
+
+
+void epd_free_region(SavedRegion_t *region)
+{
+    free(region->data);
+    region->data = NULL;
+    region->size = 0;
+}
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
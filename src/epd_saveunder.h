@@ -0,0 +1,83 @@
+/**
+ * Save-under buffers: compact snapshots of framebuffer regions that can be
+ * restored after an overlay (pressed state, popup) was drawn over them.
+ */
+
+#ifndef _EPD_SAVEUNDER_H_
+#define _EPD_SAVEUNDER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_driver.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/**
+ * @brief A run-length encoded copy of a framebuffer region.
+ */
+typedef struct
+{
+    Rect_t area;   /** The saved area, clipped and widened to whole bytes. */
+    uint8_t *data; /** Encoded rows, NULL if nothing is saved. */
+    size_t size;   /** Size of `data` in bytes. */
+} SavedRegion_t;
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/**
+ * @brief Snapshot a region of the framebuffer.
+ *
+ * @note Rows are stored PackBits encoded, uniform backgrounds take a few bytes
+ *       per row. Free the snapshot with `epd_free_region`.
+ *
+ * @param area        The region to save.
+ * @param framebuffer The framebuffer to read from.
+ * @param region      Receives the snapshot.
+ *
+ * @return false if the area is off screen or memory ran out.
+ */
+bool epd_save_region(Rect_t area, const uint8_t *framebuffer, SavedRegion_t *region);
+
+/**
+ * @brief Write a snapshot back to the framebuffer and mark its area damaged.
+ *
+ * @note Restored pixels may be lighter than what the display shows, the caller
+ *       has to flash the area before drawing it.
+ */
+void epd_restore_region(const SavedRegion_t *region, uint8_t *framebuffer);
+
+/**
+ * @brief Release a snapshot, it can be saved to again afterwards.
+ */
+void epd_free_region(SavedRegion_t *region);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
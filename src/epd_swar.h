@@ -0,0 +1,428 @@
+/**
+ * Nibble kernels working on 32 bits (eight pixels) at a time.
+ *
+ * Pixel data is a stream of nibbles in framebuffer order: the left pixel of a
+ * byte is its low nibble, and bytes are loaded little-endian, so nibble `n` of
+ * a loaded word is pixel `n` of the four bytes.
+ */
+
+#ifndef _EPD_SWAR_H_
+#define _EPD_SWAR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief A 4 bit value repeated in all eight nibbles of a word.
+ */
+#define EPD_SWAR_REPEAT(value) (((uint32_t)(value) & 0x0F) * 0x11111111u)
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/**
+ * @brief Load four bytes from any address.
+ */
+static inline uint32_t epd_swar_load(const uint8_t *p)
+{
+    uint32_t word;
+    memcpy(&word, p, 4);
+    return word;
+}
+
+/**
+ * @brief Store four bytes to any address.
+ */
+static inline void epd_swar_store(uint8_t *p, uint32_t word)
+{
+    memcpy(p, &word, 4);
+}
+
+/**
+ * @brief Swap the two pixels of every byte.
+ */
+static inline uint32_t epd_swar_swap(uint32_t word)
+{
+    return ((word & 0x0F0F0F0F) << 4) | ((word >> 4) & 0x0F0F0F0F);
+}
+
+/**
+ * @brief Advance a nibble stream by one pixel, `next` supplies the new last
+ *        pixel in its low nibble.
+ */
+static inline uint32_t epd_swar_shift(uint32_t word, uint32_t next)
+{
+    return (word >> 4) | (next << 28);
+}
+
+/**
+ * @brief 0xF in every nibble where `a` and `b` differ, 0 elsewhere.
+ */
+static inline uint32_t epd_swar_diff_mask(uint32_t a, uint32_t b)
+{
+    uint32_t diff = a ^ b;
+    diff |= diff >> 1;
+    diff |= diff >> 2;
+    return (diff & 0x11111111u) * 0xF;
+}
+
+/**
+ * @brief 0xF in every nibble that differs from `value`, 0 elsewhere.
+ */
+static inline uint32_t epd_swar_ne_mask(uint32_t word, uint8_t value)
+{
+    return epd_swar_diff_mask(word, EPD_SWAR_REPEAT(value));
+}
+
+/**
+ * @brief Take the nibbles of `b` where `mask` is set, those of `a` elsewhere.
+ */
+static inline uint32_t epd_swar_select(uint32_t a, uint32_t b, uint32_t mask)
+{
+    return (a & ~mask) | (b & mask);
+}
+
+/**
+ * @brief 0xF in nibble n where bit n of `bits` is set, 0 elsewhere.
+ */
+static inline uint32_t epd_swar_expand_bits(uint8_t bits)
+{
+    // spread the bits a nibble apart: halves, then pairs, then single bits
+    uint32_t word = bits;
+    word = (word | word << 12) & 0x000F000Fu;
+    word = (word | word << 6) & 0x03030303u;
+    word = (word | word << 3) & 0x11111111u;
+    return word * 0xF;
+}
+
+/**
+ * @brief Write `src` over `dst` except where `src` is the transparent `key`.
+ */
+static inline uint32_t epd_swar_merge_key(uint32_t dst, uint32_t src, uint8_t key)
+{
+    return epd_swar_select(dst, src, epd_swar_ne_mask(src, key));
+}
+
+/**
+ * @brief Map each byte through a 256 entry LUT, e.g. one built from a palette.
+ */
+static inline uint32_t epd_swar_remap(uint32_t word, const uint8_t *lut)
+{
+    return lut[word & 0xFF] | ((uint32_t)lut[(word >> 8) & 0xFF] << 8) |
+           ((uint32_t)lut[(word >> 16) & 0xFF] << 16) | ((uint32_t)lut[word >> 24] << 24);
+}
+
+/**
+ * @brief Swap two levels, e.g. black and white, leaving the others alone.
+ */
+static inline uint32_t epd_swar_swap_levels(uint32_t word, uint8_t a, uint8_t b)
+{
+    uint32_t mask_a = ~epd_swar_ne_mask(word, a);
+    uint32_t mask_b = ~epd_swar_ne_mask(word, b);
+    return word ^ ((mask_a | mask_b) & EPD_SWAR_REPEAT(a ^ b));
+}
+
+/**
+ * @brief Check that every pixel of a buffer has `value`, e.g. to find blank
+ *        rows.
+ */
+static inline bool epd_swar_all_equal(const uint8_t *buf, size_t len, uint8_t value)
+{
+    uint32_t repeated = EPD_SWAR_REPEAT(value);
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        if (epd_swar_load(&buf[i]) != repeated)
+            return false;
+    }
+    for (; i < len; i++)
+    {
+        if (buf[i] != (uint8_t)repeated)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Swap the two pixels of every byte of a buffer.
+ */
+static inline void epd_swar_swap_buffer(uint8_t *buf, size_t len)
+{
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        epd_swar_store(&buf[i], epd_swar_swap(epd_swar_load(&buf[i])));
+    }
+    for (; i < len; i++)
+    {
+        buf[i] = (uint8_t)epd_swar_swap(buf[i]);
+    }
+}
+
+/**
+ * @brief Swap two levels in every pixel of a buffer.
+ */
+static inline void epd_swar_swap_levels_buffer(uint8_t *buf, size_t len, uint8_t a, uint8_t b)
+{
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        epd_swar_store(&buf[i], epd_swar_swap_levels(epd_swar_load(&buf[i]), a, b));
+    }
+    for (; i < len; i++)
+    {
+        buf[i] = (uint8_t)epd_swar_swap_levels(buf[i], a, b);
+    }
+}
+
+/**
+ * @brief Copy the pixels of `src` where their bit in `bits` is set over `dst`.
+ *
+ * @param bits  One bit per pixel of the row, pixel x is bit x % 8 of byte
+ *              x / 8.
+ * @param first The row byte `dst` and `src` start at.
+ * @param len   Bytes to copy.
+ */
+static inline void epd_swar_select_bits_buffer(uint8_t *dst, const uint8_t *src, const uint8_t *bits,
+                                               size_t first, size_t len)
+{
+    size_t i = 0;
+    for (; i < len && (first + i) % 4; i++)
+    {
+        uint32_t mask = epd_swar_expand_bits(bits[(first + i) / 4] >> ((first + i) % 4 * 2));
+        dst[i] = (uint8_t)epd_swar_select(dst[i], src[i], mask);
+    }
+    for (; i + 4 <= len; i += 4)
+    {
+        uint8_t word_bits = bits[(first + i) / 4];
+        if (word_bits == 0)
+            continue;
+        uint32_t word = epd_swar_load(&src[i]);
+        if (word_bits != 0xFF)
+            word = epd_swar_select(epd_swar_load(&dst[i]), word, epd_swar_expand_bits(word_bits));
+        epd_swar_store(&dst[i], word);
+    }
+    for (; i < len; i++)
+    {
+        uint32_t mask = epd_swar_expand_bits(bits[(first + i) / 4] >> ((first + i) % 4 * 2));
+        dst[i] = (uint8_t)epd_swar_select(dst[i], src[i], mask);
+    }
+}
+
+/**
+ * @brief Set `count` pixels of a row to `value`, starting at pixel `x`.
+ */
+static inline void epd_swar_fill(uint8_t *row, int32_t x, int32_t count, uint8_t value)
+{
+    if (count <= 0)
+        return;
+    uint8_t repeated = (uint8_t)EPD_SWAR_REPEAT(value);
+    if (x % 2)
+    {
+        row[x / 2] = (row[x / 2] & 0x0F) | (repeated & 0xF0);
+        x++;
+        count--;
+    }
+    memset(&row[x / 2], repeated, count / 2);
+    if (count % 2)
+    {
+        int32_t last = (x + count) / 2;
+        row[last] = (row[last] & 0xF0) | (repeated & 0x0F);
+    }
+}
+
+/**
+ * @brief Shift a bit stream `shift` (1 to 7) bits toward the end of a buffer,
+ *        bits shifted in at the start are 0.
+ */
+static inline void epd_swar_bit_shift_buffer(uint8_t *buf, size_t len, int32_t shift)
+{
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        uint32_t word = epd_swar_load(&buf[i]);
+        epd_swar_store(&buf[i], (word << shift) | carry);
+        carry = word >> (32 - shift);
+    }
+    for (; i < len; i++)
+    {
+        uint8_t val = buf[i];
+        buf[i] = (uint8_t)((val << shift) | carry);
+        carry = val >> (8 - shift);
+    }
+}
+
+#ifdef EPD_SWAR_REFERENCE
+/**
+ * Pixel at a time definitions of the kernels, define `EPD_SWAR_REFERENCE` to
+ * check the word versions against them on a host, see test/host/test_swar.c.
+ */
+
+static inline uint8_t epd_swar_ref_pixel(uint32_t word, int32_t n)
+{
+    return (word >> (4 * n)) & 0x0F;
+}
+
+static inline uint32_t epd_swar_ref_swap(uint32_t word)
+{
+    uint32_t out = 0;
+    for (int32_t n = 0; n < 8; n++)
+        out |= (uint32_t)epd_swar_ref_pixel(word, n ^ 1) << (4 * n);
+    return out;
+}
+
+static inline uint32_t epd_swar_ref_shift(uint32_t word, uint32_t next)
+{
+    uint32_t out = 0;
+    for (int32_t n = 0; n < 7; n++)
+        out |= (uint32_t)epd_swar_ref_pixel(word, n + 1) << (4 * n);
+    return out | (uint32_t)epd_swar_ref_pixel(next, 0) << 28;
+}
+
+static inline uint32_t epd_swar_ref_ne_mask(uint32_t word, uint8_t value)
+{
+    uint32_t out = 0;
+    for (int32_t n = 0; n < 8; n++)
+        if (epd_swar_ref_pixel(word, n) != value)
+            out |= 0xFu << (4 * n);
+    return out;
+}
+
+static inline uint32_t epd_swar_ref_merge_key(uint32_t dst, uint32_t src, uint8_t key)
+{
+    uint32_t out = 0;
+    for (int32_t n = 0; n < 8; n++)
+    {
+        uint8_t pixel = epd_swar_ref_pixel(src, n);
+        out |= (uint32_t)(pixel == key ? epd_swar_ref_pixel(dst, n) : pixel) << (4 * n);
+    }
+    return out;
+}
+
+static inline uint32_t epd_swar_ref_swap_levels(uint32_t word, uint8_t a, uint8_t b)
+{
+    uint32_t out = 0;
+    for (int32_t n = 0; n < 8; n++)
+    {
+        uint8_t pixel = epd_swar_ref_pixel(word, n);
+        pixel = pixel == a ? b : pixel == b ? a : pixel;
+        out |= (uint32_t)pixel << (4 * n);
+    }
+    return out;
+}
+
+static inline uint32_t epd_swar_ref_diff_mask(uint32_t a, uint32_t b)
+{
+    uint32_t out = 0;
+    for (int32_t n = 0; n < 8; n++)
+        if (epd_swar_ref_pixel(a, n) != epd_swar_ref_pixel(b, n))
+            out |= 0xFu << (4 * n);
+    return out;
+}
+
+static inline uint32_t epd_swar_ref_select(uint32_t a, uint32_t b, uint32_t mask)
+{
+    uint32_t out = 0;
+    for (int32_t n = 0; n < 8; n++)
+    {
+        uint32_t pixel = epd_swar_ref_pixel(mask, n) ? epd_swar_ref_pixel(b, n) : epd_swar_ref_pixel(a, n);
+        out |= pixel << (4 * n);
+    }
+    return out;
+}
+
+static inline uint32_t epd_swar_ref_expand_bits(uint8_t bits)
+{
+    uint32_t out = 0;
+    for (int32_t n = 0; n < 8; n++)
+        if (bits >> n & 1)
+            out |= 0xFu << (4 * n);
+    return out;
+}
+
+static inline uint32_t epd_swar_ref_remap(uint32_t word, const uint8_t *lut)
+{
+    uint32_t out = 0;
+    for (int32_t n = 0; n < 4; n++)
+        out |= (uint32_t)lut[(word >> (8 * n)) & 0xFF] << (8 * n);
+    return out;
+}
+
+static inline uint8_t epd_swar_ref_get(const uint8_t *buf, size_t x)
+{
+    return (buf[x / 2] >> (4 * (x % 2))) & 0x0F;
+}
+
+static inline void epd_swar_ref_set(uint8_t *buf, size_t x, uint8_t value)
+{
+    buf[x / 2] = (buf[x / 2] & ~(0x0F << (4 * (x % 2)))) | (value & 0x0F) << (4 * (x % 2));
+}
+
+static inline bool epd_swar_ref_all_equal(const uint8_t *buf, size_t len, uint8_t value)
+{
+    for (size_t x = 0; x < 2 * len; x++)
+        if (epd_swar_ref_get(buf, x) != (value & 0x0F))
+            return false;
+    return true;
+}
+
+static inline void epd_swar_ref_swap_buffer(uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        buf[i] = (uint8_t)epd_swar_ref_swap(buf[i]);
+}
+
+static inline void epd_swar_ref_swap_levels_buffer(uint8_t *buf, size_t len, uint8_t a, uint8_t b)
+{
+    for (size_t i = 0; i < len; i++)
+        buf[i] = (uint8_t)epd_swar_ref_swap_levels(buf[i], a, b);
+}
+
+static inline void epd_swar_ref_select_bits_buffer(uint8_t *dst, const uint8_t *src, const uint8_t *bits,
+                                                   size_t first, size_t len)
+{
+    for (size_t x = 0; x < 2 * len; x++)
+        if (bits[(2 * first + x) / 8] >> ((2 * first + x) % 8) & 1)
+            epd_swar_ref_set(dst, x, epd_swar_ref_get(src, x));
+}
+
+static inline void epd_swar_ref_fill(uint8_t *row, int32_t x, int32_t count, uint8_t value)
+{
+    for (int32_t n = 0; n < count; n++)
+        epd_swar_ref_set(row, x + n, value);
+}
+
+static inline void epd_swar_ref_bit_shift_buffer(uint8_t *buf, size_t len, int32_t shift)
+{
+    for (size_t bit = 8 * len; bit-- > 0;)
+    {
+        uint8_t value = bit >= (size_t)shift ? (buf[(bit - shift) / 8] >> ((bit - shift) % 8)) & 1 : 0;
+        buf[bit / 8] = (buf[bit / 8] & ~(1 << (bit % 8))) | value << (bit % 8);
+    }
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -0,0 +1,313 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_text_cache.h"
+
+#include <esp_heap_caps.h>
+#include <string.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief Alignment of runs in the arena, each starts with its glyphs.
+ */
+#define RUN_ALIGN 8
+
+/**
+ * @brief Bytes compaction frees beyond the run it makes room for, so the
+ *        arena is compacted once per quarter of it filled, not on every miss.
+ */
+#define COMPACT_SLACK (EPD_TEXT_CACHE_BYTES / 4)
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+typedef struct
+{
+    uint32_t hash;
+    uint32_t last_used;
+    const GFXfont *font;
+    PlacedGlyph *glyphs;  /** Copy of the run glyphs, NULL for a free entry. */
+    int32_t count;
+    uint8_t fg_color;
+    uint8_t bg_color;
+    uint32_t flags;
+    int32_t parity;
+    size_t size;          /** Arena bytes holding glyphs, pixels and mask. */
+    TextRunBitmap_t bitmap;
+} TextCacheEntry_t;
+
+/******************************************************************************/
+/***        local function prototypes                                       ***/
+/******************************************************************************/
+
+static uint32_t hash_run(const GlyphRun *run, const FontProperties *props, int32_t parity);
+
+static bool entry_matches(const TextCacheEntry_t *entry, uint32_t hash, const GlyphRun *run,
+                          const FontProperties *props, int32_t parity);
+
+static bool same_glyphs(const PlacedGlyph *a, const PlacedGlyph *b, int32_t count);
+
+static void free_entry(TextCacheEntry_t *entry);
+
+/**
+ * @brief Move the cached runs to the start of the arena, in arena order.
+ */
+static void compact();
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+static TextCacheEntry_t entries[EPD_TEXT_CACHE_ENTRIES];
+static TextCacheStats_t stats;
+
+/**
+ * @brief Holds the cached runs, allocated once by `epd_text_cache_init`.
+ *        Runs are placed upward from `arena_top` and compacted when one does
+ *        not fit.
+ */
+static uint8_t *arena = NULL;
+static size_t arena_top = 0;
+
+/**
+ * @brief Use counter, orders the entries by recency.
+ */
+static uint32_t use_clock = 0;
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+const TextRunBitmap_t *epd_text_cache_find(const GlyphRun *run, const FontProperties *props, int32_t parity)
+{
+    uint32_t hash = hash_run(run, props, parity);
+    for (int32_t i = 0; i < EPD_TEXT_CACHE_ENTRIES; i++)
+    {
+        if (entry_matches(&entries[i], hash, run, props, parity))
+        {
+            stats.hits++;
+            entries[i].last_used = ++use_clock;
+            return &entries[i].bitmap;
+        }
+    }
+    stats.misses++;
+    return NULL;
+}
+
+
+TextRunBitmap_t *epd_text_cache_insert(const GlyphRun *run, const FontProperties *props, int32_t parity)
+{
+    int32_t byte_width = (parity + run->bounds.width + 1) / 2;
+    int32_t mask_width = (byte_width + 3) / 4;
+    int32_t height = run->bounds.height;
+    size_t glyph_bytes = run->count * sizeof(PlacedGlyph);
+    size_t pixel_bytes = (size_t)byte_width * height;
+    size_t size = glyph_bytes + pixel_bytes + (size_t)mask_width * height;
+    size = (size + RUN_ALIGN - 1) & ~(size_t)(RUN_ALIGN - 1);
+    if (size > EPD_TEXT_CACHE_MAX_RUN || size > EPD_TEXT_CACHE_BYTES ||
+        (arena == NULL && !epd_text_cache_init()))
+    {
+        return NULL;
+    }
+
+    // evict the least recently used runs until a slot is free and the run fits
+    TextCacheEntry_t *slot = NULL;
+    while (true)
+    {
+        TextCacheEntry_t *oldest = NULL;
+        slot = NULL;
+        for (int32_t i = 0; i < EPD_TEXT_CACHE_ENTRIES; i++)
+        {
+            if (entries[i].glyphs == NULL)
+            {
+                slot = &entries[i];
+            }
+            else if (oldest == NULL || entries[i].last_used < oldest->last_used)
+            {
+                oldest = &entries[i];
+            }
+        }
+        if (oldest == NULL || (slot != NULL && stats.bytes + size <= EPD_TEXT_CACHE_BYTES))
+        {
+            break;
+        }
+        free_entry(oldest);
+        stats.evictions++;
+    }
+
+    if (arena_top + size > EPD_TEXT_CACHE_BYTES)
+    {
+        while (stats.entries > 0 && stats.bytes + size + COMPACT_SLACK > EPD_TEXT_CACHE_BYTES)
+        {
+            TextCacheEntry_t *oldest = NULL;
+            for (int32_t i = 0; i < EPD_TEXT_CACHE_ENTRIES; i++)
+            {
+                if (entries[i].glyphs != NULL && (oldest == NULL || entries[i].last_used < oldest->last_used))
+                {
+                    oldest = &entries[i];
+                }
+            }
+            free_entry(oldest);
+            stats.evictions++;
+        }
+        compact();
+    }
+
+    uint8_t *data = &arena[arena_top];
+    arena_top += size;
+    memcpy(data, run->glyphs, glyph_bytes);
+    memset(data + glyph_bytes, 0, size - glyph_bytes);
+
+    slot->hash = hash_run(run, props, parity);
+    slot->last_used = ++use_clock;
+    slot->font = run->font;
+    slot->glyphs = (PlacedGlyph *)data;
+    slot->count = run->count;
+    slot->fg_color = props->fg_color;
+    slot->bg_color = props->bg_color;
+    slot->flags = props->flags;
+    slot->parity = parity;
+    slot->size = size;
+    slot->bitmap.byte_width = byte_width;
+    slot->bitmap.mask_width = mask_width;
+    slot->bitmap.height = height;
+    slot->bitmap.pixels = data + glyph_bytes;
+    slot->bitmap.mask = slot->bitmap.pixels + pixel_bytes;
+
+    stats.bytes += size;
+    stats.entries++;
+    return &slot->bitmap;
+}
+
+
+bool epd_text_cache_init()
+{
+    if (arena == NULL)
+    {
+        arena = (uint8_t *)heap_caps_malloc(EPD_TEXT_CACHE_BYTES, MALLOC_CAP_SPIRAM);
+    }
+    return arena != NULL;
+}
+
+
+void epd_text_cache_clear()
+{
+    for (int32_t i = 0; i < EPD_TEXT_CACHE_ENTRIES; i++)
+    {
+        if (entries[i].glyphs != NULL)
+        {
+            free_entry(&entries[i]);
+        }
+    }
+    memset(&stats, 0, sizeof(stats));
+    arena_top = 0;
+}
+
+
+void epd_text_cache_get_stats(TextCacheStats_t *out)
+{
+    *out = stats;
+}
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+static uint32_t hash_run(const GlyphRun *run, const FontProperties *props, int32_t parity)
+{
+    // FNV-1a over the words of the key
+    uint32_t hash = 2166136261u;
+    uint32_t words[4] = {
+        (uint32_t)(uintptr_t)run->font,
+        (uint32_t)props->fg_color | (uint32_t)props->bg_color << 4 | (uint32_t)parity << 8,
+        props->flags,
+        (uint32_t)run->count,
+    };
+    for (int32_t i = 0; i < 4; i++)
+    {
+        hash = (hash ^ words[i]) * 16777619u;
+    }
+    for (int32_t i = 0; i < run->count; i++)
+    {
+        hash = (hash ^ (uint32_t)(uintptr_t)run->glyphs[i].glyph) * 16777619u;
+        hash = (hash ^ (uint32_t)run->glyphs[i].x) * 16777619u;
+    }
+    return hash;
+}
+
+
+static bool entry_matches(const TextCacheEntry_t *entry, uint32_t hash, const GlyphRun *run,
+                          const FontProperties *props, int32_t parity)
+{
+    return entry->glyphs != NULL && entry->hash == hash && entry->font == run->font &&
+           entry->count == run->count && entry->fg_color == props->fg_color &&
+           entry->bg_color == props->bg_color && entry->flags == props->flags &&
+           entry->parity == parity && same_glyphs(entry->glyphs, run->glyphs, run->count);
+}
+
+
+static bool same_glyphs(const PlacedGlyph *a, const PlacedGlyph *b, int32_t count)
+{
+    for (int32_t i = 0; i < count; i++)
+    {
+        if (a[i].glyph != b[i].glyph || a[i].x != b[i].x)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static void free_entry(TextCacheEntry_t *entry)
+{
+    entry->glyphs = NULL;
+    stats.bytes -= entry->size;
+    stats.entries--;
+}
+
+
+static void compact()
+{
+    // move the lowest run not yet moved down, runs below `from` are in place
+    uint8_t *from = arena;
+    arena_top = 0;
+    while (true)
+    {
+        TextCacheEntry_t *lowest = NULL;
+        for (int32_t i = 0; i < EPD_TEXT_CACHE_ENTRIES; i++)
+        {
+            uint8_t *data = (uint8_t *)entries[i].glyphs;
+            if (data != NULL && data >= from && (lowest == NULL || data < (uint8_t *)lowest->glyphs))
+            {
+                lowest = &entries[i];
+            }
+        }
+        if (lowest == NULL)
+        {
+            break;
+        }
+
+        uint8_t *data = (uint8_t *)lowest->glyphs;
+        from = data + lowest->size;
+        memmove(&arena[arena_top], data, lowest->size);
+        ptrdiff_t shift = &arena[arena_top] - data;
+        lowest->glyphs = (PlacedGlyph *)&arena[arena_top];
+        lowest->bitmap.pixels += shift;
+        lowest->bitmap.mask += shift;
+        arena_top += lowest->size;
+    }
+}
+
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
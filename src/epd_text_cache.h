@@ -0,0 +1,140 @@
+/**
+ * Cache of rendered text runs, so a label drawn again in the same style is a
+ * row copy instead of drawing every glyph.
+ */
+
+#ifndef _EPD_TEXT_CACHE_H_
+#define _EPD_TEXT_CACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_driver.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief Bytes the rendered runs may take in PSRAM, allocated at init. A run
+ *        takes five bits per pixel of its bounds, four for the pixel and one
+ *        for the mask.
+ */
+#ifndef EPD_TEXT_CACHE_BYTES
+#define EPD_TEXT_CACHE_BYTES (128 * 1024)
+#endif
+
+/**
+ * @brief Bytes of the largest run cached. Longer runs are drawn glyph by
+ *        glyph, so a paragraph does not evict every label.
+ */
+#ifndef EPD_TEXT_CACHE_MAX_RUN
+#define EPD_TEXT_CACHE_MAX_RUN (EPD_TEXT_CACHE_BYTES / 8)
+#endif
+
+/**
+ * @brief Maximum number of cached runs.
+ */
+#ifndef EPD_TEXT_CACHE_ENTRIES
+#define EPD_TEXT_CACHE_ENTRIES 32
+#endif
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/**
+ * @brief A rendered run. Column 0 is the even framebuffer column at or left
+ *        of the run bounds, so rows copy byte for byte.
+ */
+typedef struct
+{
+    int32_t byte_width; /** Bytes per row of pixels. */
+    int32_t mask_width; /** Bytes per row of the mask. */
+    int32_t height;     /** Rows. */
+    uint8_t *pixels;    /** The rendered pixels. */
+    uint8_t *mask;      /** One bit per pixel, set for pixels the run draws, pixel x is bit x % 8 of byte x / 8. */
+} TextRunBitmap_t;
+
+/**
+ * @brief Cache counters since start or the last `epd_text_cache_clear`.
+ */
+typedef struct
+{
+    uint32_t hits;      /** Draws answered from the cache. */
+    uint32_t misses;    /** Draws that rendered the run. */
+    uint32_t evictions; /** Runs dropped to make room. */
+    size_t bytes;       /** Bytes currently cached. */
+    int32_t entries;    /** Runs currently cached. */
+} TextCacheStats_t;
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/**
+ * @brief Find a rendered run.
+ *
+ * @note Runs are keyed by their font, glyphs and glyph positions, the colors
+ *       and flags they are drawn with and the parity of their first column.
+ *
+ * @param run    The laid out run.
+ * @param props  The properties it is drawn with.
+ * @param parity The framebuffer column of the run bounds modulo 2.
+ *
+ * @return The bitmap, valid until the next insert, or NULL on a miss.
+ */
+const TextRunBitmap_t *epd_text_cache_find(const GlyphRun *run, const FontProperties *props, int32_t parity);
+
+/**
+ * @brief Make room for a run after a miss, the caller renders into the
+ *        returned bitmap.
+ *
+ * @note The least recently used runs are evicted until the run fits.
+ *
+ * @return The bitmap with `pixels` and `mask` cleared, or NULL if the run is
+ *         larger than `EPD_TEXT_CACHE_MAX_RUN` or the cache could not be
+ *         allocated.
+ */
+TextRunBitmap_t *epd_text_cache_insert(const GlyphRun *run, const FontProperties *props, int32_t parity);
+
+/**
+ * @brief Allocate the cache, so drawing text does not touch the heap. Called
+ *        by `epd_init`, else by the first insert.
+ *
+ * @return false if memory ran out.
+ */
+bool epd_text_cache_init();
+
+/**
+ * @brief Drop all rendered runs and reset the counters, e.g. when the display
+ *        mode changes.
+ */
+void epd_text_cache_clear();
+
+/**
+ * @brief Get the cache counters.
+ */
+void epd_text_cache_get_stats(TextCacheStats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
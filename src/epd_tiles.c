@@ -0,0 +1,229 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_tiles.h"
+#include "epd_framestore.h"
+
+#include <string.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief All tile columns of a tile row.
+ */
+#define ALL_TILES ((1u << EPD_TILES_X) - 1)
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local function prototypes                                       ***/
+/******************************************************************************/
+
+/**
+ * @brief Check whether the span [start, end) covers tile `tile` completely,
+ *        where the last tile is cut off at `limit`.
+ */
+static bool covers(int32_t start, int32_t end, int32_t tile, int32_t limit);
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+/**
+ * @brief Tile columns in which each row of the last framebuffer passed to
+ *        `epd_tiles_find_changed` differs from the stored frame. Kept per row
+ *        so unchanged rows inside a changed tile can be told apart.
+ */
+static uint32_t row_changes[EPD_HEIGHT];
+
+/**
+ * @brief Tiles for which the stored frame matches the display.
+ */
+static TileMask_t known_tiles;
+
+/**
+ * @brief Changed rows drawn into each tile since it was last flashed.
+ */
+static uint16_t tile_ghosting[EPD_TILES_Y][EPD_TILES_X];
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+int32_t epd_tiles_find_changed(const uint8_t *framebuffer, TileMask_t changed)
+{
+    memset(changed, 0, sizeof(TileMask_t));
+    for (int32_t y = 0; y < EPD_HEIGHT; y++)
+    {
+        row_changes[y] = epd_framestore_diff_row(y, &framebuffer[y * EPD_WIDTH / 2], EPD_TILE_SIZE / 2) & ALL_TILES;
+        changed[y / EPD_TILE_SIZE] |= row_changes[y];
+    }
+
+    int32_t count = 0;
+    for (int32_t ty = 0; ty < EPD_TILES_Y; ty++)
+    {
+        changed[ty] |= ~known_tiles[ty] & ALL_TILES;
+        count += __builtin_popcount(changed[ty]);
+    }
+    return count;
+}
+
+
+void epd_tiles_row_mask(Rect_t area, uint8_t *row_mask)
+{
+    memset(row_mask, 0, (area.height + 7) / 8);
+
+    int32_t tx0 = area.x < 0 ? 0 : area.x / EPD_TILE_SIZE;
+    int32_t tx1 = area.x + area.width > EPD_WIDTH ? EPD_TILES_X - 1 : (area.x + area.width - 1) / EPD_TILE_SIZE;
+    uint32_t bits = ((1u << (tx1 + 1)) - 1) & ~((1u << tx0) - 1);
+
+    for (int32_t r = 0; r < area.height; r++)
+    {
+        int32_t y = area.y + r;
+        if (y < 0 || y >= EPD_HEIGHT)
+        {
+            continue;
+        }
+        if ((row_changes[y] | ~known_tiles[y / EPD_TILE_SIZE]) & bits)
+        {
+            row_mask[r / 8] |= 1 << (r % 8);
+        }
+    }
+}
+
+
+void epd_tiles_add_damage(const TileMask_t mask, DamageList_t *list)
+{
+    for (int32_t ty = 0; ty < EPD_TILES_Y; ty++)
+    {
+        int32_t tx = 0;
+        while (tx < EPD_TILES_X)
+        {
+            if (!(mask[ty] & (1u << tx)))
+            {
+                tx++;
+                continue;
+            }
+
+            int32_t start = tx;
+            while (tx < EPD_TILES_X && (mask[ty] & (1u << tx)))
+            {
+                tx++;
+            }
+
+            Rect_t area = {
+                .x = start * EPD_TILE_SIZE,
+                .y = ty * EPD_TILE_SIZE,
+                .width = (tx - start) * EPD_TILE_SIZE,
+                .height = EPD_TILE_SIZE,
+            };
+            epd_damage_list_add(list, area);
+        }
+    }
+}
+
+
+void epd_tiles_commit(const uint8_t *framebuffer)
+{
+    // Tiles that were not known were flashed before this draw, that doesn't ghost.
+    for (int32_t y = 0; y < EPD_HEIGHT; y++)
+    {
+        int32_t ty = y / EPD_TILE_SIZE;
+        uint32_t changes = row_changes[y] & known_tiles[ty];
+        while (changes)
+        {
+            int32_t tx = __builtin_ctz(changes);
+            changes &= changes - 1;
+            if (tile_ghosting[ty][tx] < UINT16_MAX)
+            {
+                tile_ghosting[ty][tx]++;
+            }
+        }
+    }
+
+    bool stored = epd_framestore_store(framebuffer);
+    for (int32_t ty = 0; ty < EPD_TILES_Y; ty++)
+    {
+        known_tiles[ty] = stored ? ALL_TILES : 0;
+    }
+}
+
+
+void epd_tiles_invalidate(Rect_t area)
+{
+    int32_t x0 = area.x < 0 ? 0 : area.x;
+    int32_t y0 = area.y < 0 ? 0 : area.y;
+    int32_t x1 = area.x + area.width;
+    int32_t y1 = area.y + area.height;
+    if (x1 > EPD_WIDTH)
+        x1 = EPD_WIDTH;
+    if (y1 > EPD_HEIGHT)
+        y1 = EPD_HEIGHT;
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    int32_t tx0 = x0 / EPD_TILE_SIZE;
+    int32_t tx1 = (x1 - 1) / EPD_TILE_SIZE;
+    uint32_t bits = ((1u << (tx1 + 1)) - 1) & ~((1u << tx0) - 1);
+    for (int32_t ty = y0 / EPD_TILE_SIZE; ty <= (y1 - 1) / EPD_TILE_SIZE; ty++)
+    {
+        known_tiles[ty] &= ~bits;
+
+        // a partly flashed tile keeps the ghosting of the rest of it
+        if (!covers(y0, y1, ty, EPD_HEIGHT))
+        {
+            continue;
+        }
+        for (int32_t tx = tx0; tx <= tx1; tx++)
+        {
+            if (covers(x0, x1, tx, EPD_WIDTH))
+            {
+                tile_ghosting[ty][tx] = 0;
+            }
+        }
+    }
+}
+
+
+int32_t epd_tiles_find_ghosted(TileMask_t ghosted)
+{
+    int32_t count = 0;
+    for (int32_t ty = 0; ty < EPD_TILES_Y; ty++)
+    {
+        ghosted[ty] = 0;
+        for (int32_t tx = 0; tx < EPD_TILES_X; tx++)
+        {
+            if (tile_ghosting[ty][tx] > EPD_GHOSTING_BUDGET)
+            {
+                ghosted[ty] |= 1u << tx;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+static bool covers(int32_t start, int32_t end, int32_t tile, int32_t limit)
+{
+    int32_t tile_end = (tile + 1) * EPD_TILE_SIZE;
+    return start <= tile * EPD_TILE_SIZE && end >= (tile_end < limit ? tile_end : limit);
+}
+
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
@@ -0,0 +1,138 @@
+/**
+ * Change detection by comparing framebuffer tiles against the last frame
+ * that was pushed to the display.
+ */
+
+#ifndef _EPD_TILES_H_
+#define _EPD_TILES_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_damage.h"
+#include "epd_driver.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/******************************************************************************/
+/***        macro definitions                                               ***/
+/******************************************************************************/
+
+/**
+ * @brief Edge length of a square tile in pixels.
+ */
+#define EPD_TILE_SIZE 32
+
+/**
+ * @brief Number of tile columns.
+ */
+#define EPD_TILES_X (EPD_WIDTH / EPD_TILE_SIZE)
+
+/**
+ * @brief Number of tile rows, the last row may be cut off by the screen edge.
+ */
+#define EPD_TILES_Y ((EPD_HEIGHT + EPD_TILE_SIZE - 1) / EPD_TILE_SIZE)
+
+/**
+ * @brief Changed rows a tile may take without a flash before it counts as
+ *        ghosted, about eight full redraws or many small ones.
+ */
+#ifndef EPD_GHOSTING_BUDGET
+#define EPD_GHOSTING_BUDGET (8 * EPD_TILE_SIZE)
+#endif
+
+/******************************************************************************/
+/***        type definitions                                                ***/
+/******************************************************************************/
+
+/**
+ * @brief One bit per tile, bit `x` of entry `y` is tile (x, y).
+ */
+typedef uint32_t TileMask_t[EPD_TILES_Y];
+
+/******************************************************************************/
+/***        exported variables                                              ***/
+/******************************************************************************/
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/**
+ * @brief Compare all tiles of a framebuffer to the last committed frame.
+ *
+ * @note Tiles never committed, or invalidated since, always count as changed.
+ *
+ * @param framebuffer The framebuffer, `EPD_WIDTH / 2 * EPD_HEIGHT` bytes large.
+ * @param changed     Receives the changed tiles.
+ *
+ * @return The number of changed tiles.
+ */
+int32_t epd_tiles_find_changed(const uint8_t *framebuffer, TileMask_t changed);
+
+/**
+ * @brief Select the rows of an area that differ from the displayed frame.
+ *
+ * @note Uses the comparison done by the last `epd_tiles_find_changed`, so
+ *       call it in between that and the next commit. A row counts as changed if it changed
+ *       anywhere within the tile columns the area touches.
+ *
+ * @param area     The area, rows outside the screen are never selected.
+ * @param row_mask Receives one bit per row of `area` in the format taken by
+ *                 `epd_draw_image_masked`, `(area.height + 7) / 8` bytes.
+ */
+void epd_tiles_row_mask(Rect_t area, uint8_t *row_mask);
+
+/**
+ * @brief Record the tiles in `mask` as damaged areas.
+ *
+ * @note Horizontally adjacent tiles are reported as one rectangle.
+ *
+ * @param mask The tiles to add.
+ * @param list The damage list to add them to.
+ */
+void epd_tiles_add_damage(const TileMask_t mask, DamageList_t *list);
+
+/**
+ * @brief Accept a framebuffer as the frame now shown on the display.
+ *
+ * @note The frame is kept run-length encoded, see `epd_framestore_store`.
+ */
+void epd_tiles_commit(const uint8_t *framebuffer);
+
+/**
+ * @brief Forget what the display shows in an area, e.g. after it was flashed.
+ *
+ * @note Also resets the ghosting count of the tiles the area covers
+ *       completely, partly flashed tiles keep theirs.
+ */
+void epd_tiles_invalidate(Rect_t area);
+
+/**
+ * @brief Find tiles that took more than `EPD_GHOSTING_BUDGET` changed rows
+ *        since they were last flashed.
+ *
+ * @note Every commit charges each tile that was drawn without a flash with the
+ *       number of its rows that changed, as a measure of the level transitions
+ *       it went through.
+ *
+ * @param ghosted Receives the tiles that should be flashed.
+ *
+ * @return The number of ghosted tiles.
+ */
+int32_t epd_tiles_find_ghosted(TileMask_t ghosted);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/******************************************************************************/
+/***        END OF FILE                                                     ***/
+/******************************************************************************/
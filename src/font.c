@@ -4,9 +4,11 @@
 /******************************************************************************/
 
 #include "epd_driver.h"
-#include "zlib/zlib.h"
+#include "epd_damage.h"
+#include "epd_glyph_cache.h"
+#include "epd_swar.h"
+#include "epd_text_cache.h"
 
-#include <esp_assert.h>
 #include <esp_heap_caps.h>
 #include <esp_log.h>
 
@@ -19,18 +21,44 @@
 /***        macro definitions                                               ***/
 /******************************************************************************/
 
+/**
+ * @brief Code point returned for malformed UTF-8, U+FFFD REPLACEMENT CHARACTER.
+ *        Fonts without it draw their fallback glyph instead.
+ */
+#define UTF8_INVALID 0xFFFD
+
+/**
+ * @brief Glyphs `write_mode` lays out on the stack, longer strings are drawn
+ *        as several runs.
+ */
+#ifndef WRITE_STACK_GLYPHS
+#define WRITE_STACK_GLYPHS 64
+#endif
+
+/**
+ * @brief Rows of the buffer for text drawn without a framebuffer, taller runs
+ *        are drawn in bands of this height.
+ */
+#ifndef EPD_TEXT_BUFFER_ROWS
+#define EPD_TEXT_BUFFER_ROWS 64
+#endif
+
 /******************************************************************************/
 /***        type definitions                                                ***/
 /******************************************************************************/
 
+/**
+ * @brief Colors of the glyph coverage levels for one set of font properties.
+ */
 typedef struct
 {
-    uint8_t  mask;        /* char data will be bitwise AND with this */
-    uint8_t  lead;        /* start bytes of current char in utf-8 encoded character */
-    uint32_t beg;         /* beginning of codepoint range */
-    uint32_t end;         /* end of codepoint range */
-    int32_t  bits_stored; /* the number of bits from the codepoint that fits in char */
-} utf_t;
+    uint8_t fg_color;
+    uint8_t bg_color;
+    bool composite;
+    bool valid;
+    uint8_t pair_lut[256];      /** Two coverage nibbles to two colors. */
+    uint8_t blend_lut[16][256]; /** [destination level][two coverage nibbles], when compositing. */
+} GlyphStyle_t;
 
 /******************************************************************************/
 /***        local function prototypes                                       ***/
@@ -46,27 +74,89 @@ static inline int32_t max(int32_t x, int32_t y)
     return x > y ? x : y;
 }
 
-static int32_t utf8_len(const uint8_t ch);
-
-static uint32_t next_cp(uint8_t **string);
+static uint32_t next_cp(const uint8_t **string);
 
 static FontProperties font_properties_default();
 
-static void IRAM_ATTR draw_char(const GFXfont *font,
+/**
+ * @brief Get the glyph for a code point, or the fallback glyph.
+ */
+static const GFXglyph *find_glyph(const GFXfont *font, uint32_t cp, const FontProperties *props);
+
+/**
+ * @brief Lay a string out into `run->glyphs`, which has room for `max_glyphs`
+ *        glyphs.
+ *
+ * @return The rest of the string, that did not fit.
+ */
+static const char *layout_glyphs(const GFXfont *font, const char *string, size_t max_glyphs,
+                                 const FontProperties *props, GlyphRun *run);
+
+/**
+ * @brief Get the coverage colors of the font properties, rebuilt only when
+ *        the colors or the compositing flag change.
+ */
+static const GlyphStyle_t *get_style(const FontProperties *props);
+
+/**
+ * @brief Draw a glyph and move the cursor past it.
+ *
+ * @return false if the glyph bitmap could not be read.
+ */
+static bool IRAM_ATTR draw_char(const GFXfont *font,
                                 uint8_t *buffer,
                                 int32_t *cursor_x,
                                 int32_t cursor_y,
                                 uint16_t buf_width,
                                 uint16_t buf_height,
-                                uint32_t cp,
-                                const FontProperties *props);
+                                const GFXglyph *glyph,
+                                const GlyphStyle_t *style);
+
+/**
+ * @brief Draw `count` pixels of a glyph row, starting with pixel `s` of the
+ *        glyph row `src`, to a buffer row starting at pixel `x`.
+ */
+static void IRAM_ATTR blit_row(uint8_t *row, int32_t x, const uint8_t *src, int32_t s,
+                               int32_t count, const GlyphStyle_t *style);
+
+/**
+ * @brief Draw one pixel of coverage `coverage` at pixel `x` of a buffer row.
+ */
+static inline void blit_pixel(uint8_t *row, int32_t x, uint8_t coverage, const GlyphStyle_t *style);
+
+/**
+ * @brief Blend two pixels of coverage `pair` into the buffer byte `old`.
+ */
+static inline uint8_t blend_pair(uint8_t old, uint8_t pair, const GlyphStyle_t *style);
+
+/**
+ * @brief Copy a run to the framebuffer from the text cache, rendering it on a
+ *        miss. (x, y) is the top left corner of the run bounds.
+ *
+ * @return false if the run could not be cached.
+ */
+static bool write_cached_run(const GlyphRun *run, int32_t x, int32_t y,
+                             uint8_t *framebuffer, const FontProperties *props);
+
+/**
+ * @brief Draw a run with its start of the base line at (cursor_x, cursor_y)
+ *        of a buffer, with its background if the properties ask for one.
+ */
+static void draw_run(const GlyphRun *run, uint8_t *buffer, int32_t buf_width, int32_t buf_height,
+                     int32_t cursor_x, int32_t cursor_y, const FontProperties *props);
+
+/**
+ * @brief Render a flat run into a cache bitmap and mark the pixels it draws.
+ */
+static void render_run(const GlyphRun *run, int32_t parity, const FontProperties *props,
+                       TextRunBitmap_t *bitmap);
 
 /**
- * @brief Calculate the bounds of a character when drawn at (x, y), move the
+ * @brief Calculate the bounds of a glyph when drawn at (x, y), move the
  *        cursor (*x) forward, adjust the given bounds.
  */
 static void get_char_bounds(const GFXfont *font,
-                            uint32_t cp,
+                            const GFXglyph *glyph,
                             int32_t *x,
                             int32_t *y,
                             int32_t *minx,
@@ -83,43 +173,63 @@ static void get_char_bounds(const GFXfont *font,
 /***        local variables                                                 ***/
 /******************************************************************************/
 
+static GlyphStyle_t style_cache;
+
 /**
- * @brief UTF-8 decode inspired from rosetta code
- *
- * https://rosettacode.org/wiki/UTF-8_encode_and_decode#C
+ * @brief Holds a band of text drawn without a framebuffer, the screen width
+ *        and `EPD_TEXT_BUFFER_ROWS` high.
  */
-static utf_t *utf[] = {
-    /*             mask        lead        beg      end       bits */
-    [0] = &(utf_t){0b00111111, 0b10000000, 0,       0,        6},
-    [1] = &(utf_t){0b01111111, 0b00000000, 0000,    0177,     7},
-    [2] = &(utf_t){0b00011111, 0b11000000, 0200,    03777,    5},
-    [3] = &(utf_t){0b00001111, 0b11100000, 04000,   0177777,  4},
-    [4] = &(utf_t){0b00000111, 0b11110000, 0200000, 04177777, 3},
-    &(utf_t){0},
-};
+static uint8_t *text_buffer = NULL;
 
 /******************************************************************************/
 /***        exported functions                                              ***/
 /******************************************************************************/
 
+void epd_font_init()
+{
+    epd_glyph_cache_init();
+    epd_text_cache_init();
+    if (text_buffer == NULL)
+    {
+        text_buffer = (uint8_t *)heap_caps_malloc(EPD_WIDTH / 2 * EPD_TEXT_BUFFER_ROWS, MALLOC_CAP_SPIRAM);
+    }
+}
+
+
 void get_glyph(const GFXfont *font, uint32_t code_point, GFXglyph **glyph)
 {
-    UnicodeInterval *intervals = font->intervals;
     *glyph = NULL;
-    for (int32_t i = 0; i < font->interval_count; i++)
+    if (code_point < font->direct_count)
     {
-        UnicodeInterval *interval = &intervals[i];
-        if (code_point >= interval->first && code_point <= interval->last)
+        uint16_t index = font->direct_index[code_point];
+        if (index != GLYPH_INDEX_NONE)
         {
-            *glyph = &font->glyph[interval->offset + (code_point - interval->first)];
-            return;
+            *glyph = &font->glyph[index];
         }
+        return;
+    }
+
+    UnicodeInterval *intervals = font->intervals;
+    int32_t low = 0;
+    int32_t high = (int32_t)font->interval_count - 1;
+    while (low <= high)
+    {
+        int32_t mid = (low + high) / 2;
+        UnicodeInterval *interval = &intervals[mid];
         if (code_point < interval->first)
         {
+            high = mid - 1;
+        }
+        else if (code_point > interval->last)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            *glyph = &font->glyph[interval->offset + (code_point - interval->first)];
             return;
         }
     }
-    return;
 }
 
 
@@ -154,9 +264,9 @@ void get_text_bounds(const GFXfont *font,
     int32_t minx = 100000, miny = 100000, maxx = -1, maxy = -1;
     int32_t original_x = *x;
     uint32_t c;
-    while ((c = next_cp((uint8_t **)&string)))
+    while ((c = next_cp((const uint8_t **)&string)))
     {
-        get_char_bounds(font, c, x, y, &minx, &miny, &maxx, &maxy, &props);
+        get_char_bounds(font, find_glyph(font, c, &props), x, y, &minx, &miny, &maxx, &maxy, &props);
     }
     *x1 = min(original_x, minx);
     *w = maxx - *x1;
@@ -164,87 +274,146 @@ void get_text_bounds(const GFXfont *font,
     *h = maxy - miny;
 }
 
-void write_mode(const GFXfont *font,
-                const char *string,
-                int32_t *cursor_x,
-                int32_t *cursor_y,
-                uint8_t *framebuffer,
-                DrawMode_t mode,
-                const FontProperties *properties)
+bool layout_text(const GFXfont *font,
+                 const char *string,
+                 const FontProperties *properties,
+                 GlyphRun *run)
 {
-    if (*string == '\0') return ;
-
     FontProperties props = (properties == NULL) ? font_properties_default() \
                                                 : *properties;
 
-    int32_t x1 = 0, y1 = 0, w = 0, h = 0;
-    int32_t tmp_cur_x = *cursor_x;
-    int32_t tmp_cur_y = *cursor_y;
-    get_text_bounds(font, string, &tmp_cur_x, &tmp_cur_y, &x1, &y1, &w, &h, &props);
+    run->font = font;
+    run->glyphs = NULL;
+    run->count = 0;
+    run->advance = 0;
+    run->bounds = (Rect_t){.x = 0, .y = 0, .width = 0, .height = 0};
 
-    uint8_t *buffer;
-    int32_t buf_width;
-    int32_t buf_height;
-    int32_t baseline_height = *cursor_y - y1;
-
-    // The local cursor position:
-    // 0, if drawing to a local temporary buffer
-    // the given cursor position, if drawing to a full frame buffer
-    int32_t local_cursor_x = 0;
-    int32_t local_cursor_y = 0;
-
-    if (framebuffer == NULL)
+    // at most one glyph per byte
+    size_t max_glyphs = strlen(string);
+    if (max_glyphs == 0)
     {
-        buf_width = (w / 2 + w % 2);
-        buf_height = h;
-        buffer = (uint8_t *)malloc(buf_width * buf_height);
-        memset(buffer, 255, buf_width * buf_height);
-        local_cursor_y = buf_height - baseline_height;
+        return true;
     }
-    else
+    run->glyphs = (PlacedGlyph *)malloc(max_glyphs * sizeof(PlacedGlyph));
+    if (run->glyphs == NULL)
     {
-        buf_width = EPD_WIDTH / 2;
-        buf_height = EPD_HEIGHT;
-        buffer = framebuffer;
-        local_cursor_x = *cursor_x;
-        local_cursor_y = *cursor_y;
+        ESP_LOGE("font.c", "cannot allocate glyph run!");
+        return false;
     }
 
-    uint32_t c;
+    layout_glyphs(font, string, max_glyphs, &props, run);
+    return true;
+}
 
-    int32_t cursor_x_init = local_cursor_x;
-    int32_t cursor_y_init = local_cursor_y;
 
-    uint8_t bg = props.bg_color;
-    if (props.flags & DRAW_BACKGROUND)
+void write_glyph_run(const GlyphRun *run,
+                     int32_t *cursor_x,
+                     int32_t *cursor_y,
+                     uint8_t *framebuffer,
+                     DrawMode_t mode,
+                     const FontProperties *properties)
+{
+    if (run->count == 0) return ;
+
+    FontProperties props = (properties == NULL) ? font_properties_default() \
+                                                : *properties;
+
+    int32_t x1 = *cursor_x + run->bounds.x;
+    int32_t w = run->bounds.width;
+    int32_t h = run->bounds.height;
+    int32_t baseline_height = run->bounds.y + h;
+
+    if (framebuffer == NULL)
     {
-        for (int32_t l = 0; l < font->advance_y; l++)
+        // the part of the run on the screen, drawn a band of rows at a time
+        Rect_t area = {
+            .x = max(0, x1),
+            .y = max(0, *cursor_y + run->bounds.y),
+        };
+        area.width = min(EPD_WIDTH, x1 + w) - area.x;
+        area.height = min(EPD_HEIGHT, *cursor_y + baseline_height) - area.y;
+        if (area.width <= 0 || area.height <= 0)
         {
-            epd_draw_hline(local_cursor_x,
-                           local_cursor_y - (font->advance_y - baseline_height) + l,
-                           w,
-                           bg << 4,
-                           buffer);
+            *cursor_x += run->advance;
+            return;
         }
+        if (text_buffer == NULL)
+        {
+            epd_font_init();
+        }
+        if (text_buffer == NULL)
+        {
+            ESP_LOGE("font.c", "cannot allocate text buffer!");
+            return;
+        }
+
+        int32_t buf_width = (area.width / 2 + area.width % 2);
+        Rect_t band = area;
+        for (band.y = area.y; band.y < area.y + area.height; band.y += EPD_TEXT_BUFFER_ROWS)
+        {
+            band.height = min(EPD_TEXT_BUFFER_ROWS, area.y + area.height - band.y);
+            memset(text_buffer, 255, buf_width * band.height);
+            draw_run(run, text_buffer, buf_width, band.height, *cursor_x - band.x, *cursor_y - band.y, &props);
+            epd_draw_image(band, text_buffer, mode);
+        }
+        *cursor_x += run->advance;
+        return;
+    }
+
+    Rect_t text_area = {
+        .x = x1,
+        .y = *cursor_y + run->bounds.y,
+        .width = w,
+        .height = h
+    };
+    epd_damage_add(text_area);
+
+    // flat text does not depend on what is under it, draw it from the cache
+    if (!(props.flags & (DRAW_BACKGROUND | DRAW_COMPOSITE)) &&
+        write_cached_run(run, text_area.x, text_area.y, framebuffer, &props))
+    {
+        *cursor_x += run->advance;
+        return;
     }
-    while ((c = next_cp((uint8_t **)&string)))
+
+    if (props.flags & DRAW_BACKGROUND)
     {
-        draw_char(font, buffer, &local_cursor_x, local_cursor_y, buf_width, buf_height, c, &props);
+        int32_t bg_y = *cursor_y - (run->font->advance_y - baseline_height);
+        epd_damage_add((Rect_t){.x = *cursor_x, .y = bg_y, .width = w, .height = run->font->advance_y});
     }
+    draw_run(run, framebuffer, EPD_WIDTH / 2, EPD_HEIGHT, *cursor_x, *cursor_y, &props);
+    *cursor_x += run->advance;
+}
 
-    *cursor_x += local_cursor_x - cursor_x_init;
-    *cursor_y += local_cursor_y - cursor_y_init;
 
-    if (framebuffer == NULL)
+void free_glyph_run(GlyphRun *run)
+{
+    free(run->glyphs);
+    run->glyphs = NULL;
+    run->count = 0;
+}
+
+
+void write_mode(const GFXfont *font,
+                const char *string,
+                int32_t *cursor_x,
+                int32_t *cursor_y,
+                uint8_t *framebuffer,
+                DrawMode_t mode,
+                const FontProperties *properties)
+{
+    if (*string == '\0') return ;
+
+    // strings are laid out on the stack, drawing them does not touch the heap
+    FontProperties props = (properties == NULL) ? font_properties_default() \
+                                                : *properties;
+    PlacedGlyph glyphs[WRITE_STACK_GLYPHS];
+    GlyphRun run;
+    run.glyphs = glyphs;
+    while (*string != '\0')
     {
-        Rect_t area = {
-            .x = x1,
-            .y = *cursor_y - h + baseline_height,
-            .width = w,
-            .height = h
-        };
-        epd_draw_image(area, buffer, mode);
-        free(buffer);
+        string = layout_glyphs(font, string, WRITE_STACK_GLYPHS, &props, &run);
+        write_glyph_run(&run, cursor_x, cursor_y, framebuffer, mode, properties);
     }
 }
 
@@ -294,42 +463,74 @@ void write_string(const GFXfont *font,
 /***        local functions                                                 ***/
 /******************************************************************************/
 
-static int32_t utf8_len(const uint8_t ch)
+/**
+ * @brief Decode the next code point and advance the string past it.
+ *
+ * @note Overlong forms, surrogates, code points above U+10FFFF and truncated
+ *       sequences decode to `UTF8_INVALID`. A sequence cut short by a
+ *       non-continuation byte consumes only the bytes before it, so the
+ *       terminating NUL is never skipped.
+ *
+ * @return The code point, 0 at the end of the string.
+ */
+static uint32_t next_cp(const uint8_t **string)
 {
-    int32_t len = 0;
-    for (utf_t **u = utf; *u; ++u)
+    const uint8_t *s = *string;
+    uint32_t cp = s[0];
+
+    // ASCII, including the terminator
+    if (cp < 0x80)
     {
-        if ((ch & ~(*u)->mask) == (*u)->lead)
+        if (cp != 0)
         {
-            break;
+            (*string)++;
         }
-        ++len;
+        return cp;
     }
-    if (len > 4)
-    { /* Malformed leading byte */
-        assert("invalid unicode.");
-    }
-    return len;
-}
-
-
-static uint32_t next_cp(uint8_t **string)
-{
-    if (**string == 0) return 0;
 
-    int32_t bytes = utf8_len(**string);
-    uint8_t *chr = *string;
-    *string += bytes;
-    int32_t shift = utf[0]->bits_stored * (bytes - 1);
-    uint32_t codep = (*chr++ & utf[bytes]->mask) << shift;
+    int32_t len;
+    uint32_t min_cp;
+    if (cp >= 0xC2 && cp <= 0xDF)
+    {
+        len = 2;
+        min_cp = 0x80;
+        cp &= 0x1F;
+    }
+    else if ((cp & 0xF0) == 0xE0)
+    {
+        len = 3;
+        min_cp = 0x800;
+        cp &= 0x0F;
+    }
+    else if (cp >= 0xF0 && cp <= 0xF4)
+    {
+        len = 4;
+        min_cp = 0x10000;
+        cp &= 0x07;
+    }
+    else
+    {
+        // stray continuation byte, 0xC0, 0xC1 or 0xF5 and above
+        (*string)++;
+        return UTF8_INVALID;
+    }
 
-    for (int32_t i = 1; i < bytes; ++i, ++chr)
+    for (int32_t i = 1; i < len; i++)
     {
-        shift -= utf[0]->bits_stored;
-        codep |= ((uint8_t)*chr & utf[0]->mask) << shift;
+        if ((s[i] & 0xC0) != 0x80)
+        {
+            *string += i;
+            return UTF8_INVALID;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
     }
+    *string += len;
 
-    return codep;
+    if (cp < min_cp || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+    {
+        return UTF8_INVALID;
+    }
+    return cp;
 }
 
 
@@ -345,14 +546,7 @@ static FontProperties font_properties_default()
 }
 
 
-static void IRAM_ATTR draw_char(const GFXfont *font,
-                                uint8_t *buffer,
-                                int32_t *cursor_x,
-                                int32_t cursor_y,
-                                uint16_t buf_width,
-                                uint16_t buf_height,
-                                uint32_t cp,
-                                const FontProperties *props)
+static const GFXglyph *find_glyph(const GFXfont *font, uint32_t cp, const FontProperties *props)
 {
     GFXglyph *glyph;
     get_glyph(font, cp, &glyph);
@@ -361,84 +555,322 @@ static void IRAM_ATTR draw_char(const GFXfont *font,
     {
         get_glyph(font, props->fallback_glyph, &glyph);
     }
+    return glyph;
+}
 
-    if (!glyph)
+
+static const GlyphStyle_t *get_style(const FontProperties *props)
+{
+    bool composite = props->flags & DRAW_COMPOSITE;
+    GlyphStyle_t *style = &style_cache;
+    if (style->valid && style->fg_color == props->fg_color &&
+        style->bg_color == props->bg_color && style->composite == composite)
     {
-        return;
+        return style;
     }
 
-    uint32_t offset = glyph->data_offset;
-    uint8_t width = glyph->width;
-    uint8_t height = glyph->height;
-    int32_t left = glyph->left;
+    uint8_t color_lut[16];
+    int32_t color_difference = (int32_t)props->fg_color - (int32_t)props->bg_color;
+    for (int32_t c = 0; c < 16; c++)
+    {
+        color_lut[c] = max(0, min(15, props->bg_color + c * color_difference / 15));
+    }
+    for (int32_t pair = 0; pair < 256; pair++)
+    {
+        style->pair_lut[pair] = color_lut[pair & 0x0F] | color_lut[pair >> 4] << 4;
+    }
 
-    int32_t byte_width = (width / 2 + width % 2);
-    unsigned long bitmap_size = byte_width * height;
-    uint8_t *bitmap = NULL;
-    if (font->compressed)
+    if (composite)
     {
-        bitmap = (uint8_t *)malloc(bitmap_size);
-        uncompress(bitmap, &bitmap_size, &font->bitmap[offset], glyph->compressed_size);
+        // one pair table per level under the glyph, like pair_lut over bg_color
+        for (int32_t d = 0; d < 16; d++)
+        {
+            int32_t difference = (int32_t)props->fg_color - d;
+            for (int32_t c = 0; c < 16; c++)
+            {
+                color_lut[c] = d + (c * difference + (difference < 0 ? -7 : 7)) / 15;
+            }
+            for (int32_t pair = 0; pair < 256; pair++)
+            {
+                style->blend_lut[d][pair] = color_lut[pair & 0x0F] | color_lut[pair >> 4] << 4;
+            }
+        }
     }
-    else
+
+    style->fg_color = props->fg_color;
+    style->bg_color = props->bg_color;
+    style->composite = composite;
+    style->valid = true;
+    return style;
+}
+
+
+static const char *layout_glyphs(const GFXfont *font, const char *string, size_t max_glyphs,
+                                 const FontProperties *props, GlyphRun *run)
+{
+    run->font = font;
+    run->count = 0;
+    run->advance = 0;
+    run->bounds = (Rect_t){.x = 0, .y = 0, .width = 0, .height = 0};
+
+    int32_t minx = 100000, miny = 100000, maxx = -1, maxy = -1;
+    int32_t x = 0;
+    int32_t y = 0;
+    uint32_t c;
+    while ((size_t)run->count < max_glyphs && (c = next_cp((const uint8_t **)&string)))
     {
-        bitmap = &font->bitmap[offset];
+        const GFXglyph *glyph = find_glyph(font, c, props);
+        if (glyph == NULL)
+        {
+            continue;
+        }
+        run->glyphs[run->count].glyph = glyph;
+        run->glyphs[run->count].x = x;
+        run->count++;
+        get_char_bounds(font, glyph, &x, &y, &minx, &miny, &maxx, &maxy, props);
     }
+    run->advance = x;
 
-    uint8_t color_lut[16];
-    for (int32_t c = 0; c < 16; c++)
+    if (run->count > 0)
     {
-        int32_t color_difference = (int32_t)props->fg_color - (int32_t)props->bg_color;
-        color_lut[c] = max(0, min(15, props->bg_color + c * color_difference / 15));
+        // get_char_bounds counts y upward from the base line
+        run->bounds.x = min(0, minx);
+        run->bounds.y = -maxy;
+        run->bounds.width = maxx - run->bounds.x;
+        run->bounds.height = maxy - miny;
+    }
+    return string;
+}
+
+
+static bool IRAM_ATTR draw_char(const GFXfont *font,
+                                uint8_t *buffer,
+                                int32_t *cursor_x,
+                                int32_t cursor_y,
+                                uint16_t buf_width,
+                                uint16_t buf_height,
+                                const GFXglyph *glyph,
+                                const GlyphStyle_t *style)
+{
+    if (!glyph)
+    {
+        return false;
     }
 
-    for (int32_t y = 0; y < height; y++)
+    int32_t byte_width = (glyph->width / 2 + glyph->width % 2);
+    const uint8_t *bitmap = epd_glyph_cache_get(font, glyph);
+    if (bitmap == NULL)
+    {
+        *cursor_x += glyph->advance_x;
+        return false;
+    }
+
+    // clip the glyph columns to the buffer
+    int32_t start_pos = *cursor_x + glyph->left;
+    int32_t first = max(0, -start_pos);
+    int32_t last = min(glyph->width, buf_width * 2 - start_pos);
+
+    for (int32_t y = 0; y < glyph->height && first < last; y++)
     {
         int32_t yy = cursor_y - glyph->top + y;
         if (yy < 0 || yy >= buf_height)
         {
             continue;
         }
-        int32_t start_pos = *cursor_x + left;
-        bool byte_complete = start_pos % 2;
-        int32_t x = max(0, -start_pos);
-        int32_t max_x = min(start_pos + width, buf_width * 2);
-        for (int32_t xx = start_pos; xx < max_x; xx++)
+        blit_row(&buffer[yy * buf_width], start_pos + first, &bitmap[y * byte_width], first,
+                 last - first, style);
+    }
+    *cursor_x += glyph->advance_x;
+    return true;
+}
+
+
+static void IRAM_ATTR blit_row(uint8_t *row, int32_t x, const uint8_t *src, int32_t s,
+                               int32_t count, const GlyphStyle_t *style)
+{
+    // start on a byte of the row, then draw two pixels per byte
+    if (x & 1)
+    {
+        blit_pixel(row, x, (src[s / 2] >> ((s & 1) * 4)) & 0x0F, style);
+        x++;
+        s++;
+        count--;
+    }
+
+    // with an odd source column, each pair of pixels straddles two source bytes
+    uint8_t *dst = &row[x / 2];
+    const uint8_t *p = &src[s / 2];
+    bool shifted = s & 1;
+    int32_t pairs = count / 2;
+    int32_t i = 0;
+    for (; i + 4 <= pairs; i += 4)
+    {
+        uint32_t word = epd_swar_load(&p[i]);
+        if (shifted)
+        {
+            word = epd_swar_shift(word, p[i + 4]);
+        }
+        if (!style->composite)
+        {
+            epd_swar_store(&dst[i], epd_swar_remap(word, style->pair_lut));
+        }
+        else if (word != 0)
         {
-            uint32_t buf_pos = yy * buf_width + xx / 2;
-            uint8_t old = buffer[buf_pos];
-            uint8_t bm = bitmap[y * byte_width + x / 2];
-            if ((x & 1) == 0)
+            // zero coverage leaves the pixels as they are, over a uniform
+            // level the blend is a pair lookup like flat text
+            uint32_t old = epd_swar_load(&dst[i]);
+            if (old == EPD_SWAR_REPEAT(old))
             {
-                bm = bm & 0xF;
+                epd_swar_store(&dst[i], epd_swar_remap(word, style->blend_lut[old & 0x0F]));
             }
             else
             {
-                bm = bm >> 4;
+                for (int32_t b = 0; b < 4; b++, word >>= 8, old >>= 8)
+                {
+                    dst[i + b] = blend_pair(old, word, style);
+                }
             }
+        }
+    }
+    for (; i < pairs; i++)
+    {
+        uint8_t pair = shifted ? (uint8_t)((p[i] >> 4) | (p[i + 1] << 4)) : p[i];
+        if (!style->composite)
+        {
+            dst[i] = style->pair_lut[pair];
+        }
+        else if (pair != 0)
+        {
+            dst[i] = blend_pair(dst[i], pair, style);
+        }
+    }
 
-            if ((xx & 1) == 0)
-            {
-                buffer[buf_pos] = (old & 0xF0) | color_lut[bm];
-            }
-            else
-            {
-                buffer[buf_pos] = (old & 0x0F) | (color_lut[bm] << 4);
-            }
-            byte_complete = !byte_complete;
-            x++;
+    if (count & 1)
+    {
+        s += 2 * pairs;
+        blit_pixel(row, x + 2 * pairs, (src[s / 2] >> ((s & 1) * 4)) & 0x0F, style);
+    }
+}
+
+
+static inline void blit_pixel(uint8_t *row, int32_t x, uint8_t coverage, const GlyphStyle_t *style)
+{
+    uint8_t old = row[x / 2];
+    uint8_t color;
+    if (x & 1)
+    {
+        color = style->composite ? style->blend_lut[old >> 4][coverage] : style->pair_lut[coverage];
+        row[x / 2] = (old & 0x0F) | (color & 0x0F) << 4;
+    }
+    else
+    {
+        color = style->composite ? style->blend_lut[old & 0x0F][coverage] : style->pair_lut[coverage];
+        row[x / 2] = (old & 0xF0) | (color & 0x0F);
+    }
+}
+
+
+static inline uint8_t blend_pair(uint8_t old, uint8_t pair, const GlyphStyle_t *style)
+{
+    return (style->blend_lut[old & 0x0F][pair] & 0x0F) | (style->blend_lut[old >> 4][pair] & 0xF0);
+}
+
+
+static bool write_cached_run(const GlyphRun *run, int32_t x, int32_t y,
+                             uint8_t *framebuffer, const FontProperties *props)
+{
+    // the bitmap starts at an even column so its rows copy byte for byte
+    int32_t parity = x & 1;
+    const TextRunBitmap_t *bitmap = epd_text_cache_find(run, props, parity);
+    if (bitmap == NULL)
+    {
+        TextRunBitmap_t *fresh = epd_text_cache_insert(run, props, parity);
+        if (fresh == NULL)
+        {
+            return false;
         }
+        render_run(run, parity, props, fresh);
+        bitmap = fresh;
     }
-    if (font->compressed)
+
+    int32_t x0 = x - parity;
+    int32_t first = max(0, -x0 / 2);
+    int32_t last = min(bitmap->byte_width, (EPD_WIDTH - x0) / 2);
+    for (int32_t row = 0; row < bitmap->height && first < last; row++)
     {
-        free(bitmap);
+        int32_t yy = y + row;
+        if (yy < 0 || yy >= EPD_HEIGHT)
+        {
+            continue;
+        }
+        epd_swar_select_bits_buffer(&framebuffer[yy * EPD_WIDTH / 2 + x0 / 2 + first],
+                                    &bitmap->pixels[(size_t)row * bitmap->byte_width + first],
+                                    &bitmap->mask[(size_t)row * bitmap->mask_width], first, last - first);
+    }
+    return true;
+}
+
+
+static void draw_run(const GlyphRun *run, uint8_t *buffer, int32_t buf_width, int32_t buf_height,
+                     int32_t cursor_x, int32_t cursor_y, const FontProperties *props)
+{
+    const GFXfont *font = run->font;
+    if (props->flags & DRAW_BACKGROUND)
+    {
+        // the background spans the line height, which may exceed the run bounds
+        int32_t bg_y = cursor_y - (font->advance_y - run->bounds.y - run->bounds.height);
+        int32_t bg_x = max(0, cursor_x);
+        int32_t bg_end = min(buf_width * 2, cursor_x + run->bounds.width);
+        for (int32_t l = max(0, bg_y); l < min(buf_height, bg_y + font->advance_y); l++)
+        {
+            epd_swar_fill(&buffer[l * buf_width], bg_x, bg_end - bg_x, props->bg_color);
+        }
+    }
+
+    const GlyphStyle_t *style = get_style(props);
+    for (int32_t i = 0; i < run->count; i++)
+    {
+        int32_t glyph_x = cursor_x + run->glyphs[i].x;
+        draw_char(font, buffer, &glyph_x, cursor_y, buf_width, buf_height, run->glyphs[i].glyph, style);
+    }
+}
+
+
+static void render_run(const GlyphRun *run, int32_t parity, const FontProperties *props,
+                       TextRunBitmap_t *bitmap)
+{
+    // Flat text draws every pixel of its glyph boxes, the mask is the boxes
+    // of the glyphs drawn
+    const GlyphStyle_t *style = get_style(props);
+    int32_t cursor_y = -run->bounds.y;
+    for (int32_t i = 0; i < run->count; i++)
+    {
+        const GFXglyph *glyph = run->glyphs[i].glyph;
+        int32_t cursor_x = parity - run->bounds.x + run->glyphs[i].x;
+        int32_t left = cursor_x + glyph->left;
+        int32_t top = cursor_y - glyph->top;
+        if (!draw_char(run->font, bitmap->pixels, &cursor_x, cursor_y, bitmap->byte_width,
+                       bitmap->height, glyph, style))
+        {
+            continue;
+        }
+
+        int32_t first = max(0, left);
+        int32_t last = min(2 * bitmap->byte_width, left + glyph->width);
+        for (int32_t y = max(0, top); y < min(bitmap->height, top + glyph->height); y++)
+        {
+            uint8_t *mask = &bitmap->mask[(size_t)y * bitmap->mask_width];
+            for (int32_t x = first; x < last; x++)
+            {
+                mask[x / 8] |= 1 << (x % 8);
+            }
+        }
     }
-    *cursor_x += glyph->advance_x;
 }
 
 
 static void get_char_bounds(const GFXfont *font,
-                            uint32_t cp,
+                            const GFXglyph *glyph,
                             int32_t *x,
                             int32_t *y,
                             int32_t *minx,
@@ -447,14 +879,6 @@ static void get_char_bounds(const GFXfont *font,
                             int32_t *maxy,
                             const FontProperties *props)
 {
-    GFXglyph *glyph;
-    get_glyph(font, cp, &glyph);
-
-    if (!glyph)
-    {
-        get_glyph(font, props->fallback_glyph, &glyph);
-    }
-
     if (!glyph) return ;
 
     int32_t x1 = *x + glyph->left;
@@ -0,0 +1,108 @@
+/**
+ * @file bench_blit.c
+ * @brief Time `epd_blit` on a 128x128 icon and 300x300 album art at even and
+ *        odd columns, opaque and with a transparent key, against the pixel by
+ *        pixel copy `epd_copy_to_framebuffer` used to do.
+ */
+
+#include "host.h"
+#include "pages.h"
+
+#include <string.h>
+
+#define FRAMEBUFFER_SIZE (EPD_WIDTH / 2 * EPD_HEIGHT)
+#define PIXELS_PER_RUN (16 * 1000 * 1000)
+
+static uint8_t framebuffer[FRAMEBUFFER_SIZE];
+static uint8_t expected[FRAMEBUFFER_SIZE];
+static uint8_t image[300 * 150];
+
+/**
+ * @brief The pixel by pixel copy `epd_blit` replaced, as the reference.
+ */
+static void pixel_copy(Rect_t image_area, const uint8_t *image_data, uint8_t *framebuffer)
+{
+    for (int32_t i = 0; i < image_area.width * image_area.height; i++)
+    {
+        int32_t value_index = i;
+        // for images of uneven width,
+        // consume an additional nibble per row.
+        if (image_area.width % 2)
+        {
+            value_index += i / image_area.width;
+        }
+        uint8_t val = (value_index % 2) ? (image_data[value_index / 2] & 0xF0) >> 4
+                                        : image_data[value_index / 2] & 0x0F;
+
+        int32_t xx = image_area.x + i % image_area.width;
+        if (xx < 0 || xx >= EPD_WIDTH)
+        {
+            continue;
+        }
+        int32_t yy = image_area.y + i / image_area.width;
+        if (yy < 0 || yy >= EPD_HEIGHT)
+        {
+            continue;
+        }
+        uint8_t *buf_ptr = &framebuffer[yy * EPD_WIDTH / 2 + xx / 2];
+        if (xx % 2)
+        {
+            *buf_ptr = (*buf_ptr & 0x0F) | (val << 4);
+        }
+        else
+        {
+            *buf_ptr = (*buf_ptr & 0xF0) | val;
+        }
+    }
+}
+
+/**
+ * @brief Time blits of the image at `area` in megapixels per second.
+ *
+ * @param flags The `BlitFlags`, or -1 for the pixel by pixel copy.
+ */
+static double time_blit(Rect_t area, int32_t flags)
+{
+    int32_t repeats = PIXELS_PER_RUN / (area.width * area.height);
+    double start = host_now();
+
+    for (int32_t i = 0; i < repeats; i++)
+    {
+        if (flags < 0)
+            pixel_copy(area, image, framebuffer);
+        else
+            epd_blit(area, image, framebuffer, flags, 15);
+    }
+    return (double)repeats * area.width * area.height / (host_now() - start) / 1e6;
+}
+
+int main()
+{
+    static const int32_t sizes[] = {128, 300};
+
+    printf("%-8s %6s %14s %14s %14s\n", "image", "x", "pixel Mpx/s", "blit Mpx/s", "keyed Mpx/s");
+    for (int32_t s = 0; s < 2; s++)
+    {
+        for (int32_t x = 100; x < 102; x++)
+        {
+            Rect_t area = {.x = x, .y = 100, .width = sizes[s], .height = sizes[s]};
+            double pixel, blit, keyed;
+
+            sample_image(area.width, area.height, 5, image);
+
+            // the blit draws what the pixel by pixel copy draws
+            memset(expected, 0xFF, FRAMEBUFFER_SIZE);
+            pixel_copy(area, image, expected);
+            memset(framebuffer, 0xFF, FRAMEBUFFER_SIZE);
+            epd_blit(area, image, framebuffer, 0, 0);
+            CHECK(memcmp(framebuffer, expected, FRAMEBUFFER_SIZE) == 0);
+
+            pixel = time_blit(area, -1);
+            blit = time_blit(area, 0);
+            keyed = time_blit(area, BLIT_TRANSPARENT);
+            printf("%3dx%-4d %6s %14.1f %14.1f %14.1f\n", (int)area.width, (int)area.height,
+                   x & 1 ? "odd" : "even", pixel, blit, keyed);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file bench_codecs.c
+ * @brief Compare the glyph codecs of FiraSans: the flash their bitmaps take
+ *        and how fast the glyph cache decodes them on a miss.
+ */
+
+#include "host.h"
+#include "codecs.h"
+
+#include "epd_glyph_cache.h"
+
+#define ROUNDS 20
+
+static const enum GlyphCodec codecs[] = {GLYPH_CODEC_NONE, GLYPH_CODEC_ZLIB, GLYPH_CODEC_DEFLATE, GLYPH_CODEC_RLE};
+
+/**
+ * @brief Decode every glyph, each round from an empty cache.
+ *
+ * @return Glyphs per second of the fastest round.
+ */
+static double decode_all(const GFXfont *font)
+{
+    double best = 0;
+
+    for (int32_t round = 0; round < ROUNDS; round++)
+    {
+        epd_glyph_cache_clear();
+        double start = host_now();
+        for (uint32_t i = 0; i < codec_glyph_count(); i++)
+            host_sink += epd_glyph_cache_get(font, &font->glyph[i]) != NULL;
+        double rate = codec_glyph_count() / (host_now() - start);
+        best = rate > best ? rate : best;
+    }
+    return best;
+}
+
+int main()
+{
+    const GFXfont *plain = codec_font(GLYPH_CODEC_NONE);
+    size_t unpacked = codec_flash_bytes(plain);
+    size_t zlib_bytes = codec_flash_bytes(codec_font(GLYPH_CODEC_ZLIB));
+    double zlib_rate = 0;
+
+    printf("%u glyphs, %zu bytes unpacked\n", (unsigned)codec_glyph_count(), unpacked);
+    printf("codec      flash bytes  vs zlib   M glyphs/s    MB/s  vs zlib\n");
+    for (int32_t c = 0; c < 4; c++)
+    {
+        const GFXfont *font = codec_font(codecs[c]);
+        size_t bytes = codec_flash_bytes(font);
+
+        printf("%-8s %13zu %7.1f%%", codec_name(codecs[c]), bytes, (bytes * 100.0) / zlib_bytes);
+        if (codecs[c] == GLYPH_CODEC_NONE)
+        {
+            // in memory, the cache hands out the bitmaps without decoding
+            printf("            -       -        -\n");
+            continue;
+        }
+        double rate = decode_all(font);
+        if (codecs[c] == GLYPH_CODEC_ZLIB)
+            zlib_rate = rate;
+        printf("  %11.3f %7.0f %7.2fx\n", rate / 1e6, rate * unpacked / codec_glyph_count() / 1e6,
+               rate / zlib_rate);
+    }
+    return 0;
+}
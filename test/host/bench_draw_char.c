@@ -0,0 +1,87 @@
+/**
+ * @file bench_draw_char.c
+ * @brief Glyph throughput of `draw_char` from font.c against the old pixel at
+ *        a time renderer, flat and composite, on the bench_text labels.
+ */
+
+#include "font.c"
+
+#include "host.h"
+#include "pages.h"
+#include "draw_char_old.h"
+
+#define FRAMEBUFFER_SIZE (EPD_WIDTH / 2 * EPD_HEIGHT)
+#define DRAWS 20000
+#define ROUNDS 5
+
+static const char *const labels[] = {
+    "Living room", "21.5 °C", "Humidity 45%", "Front door locked",
+    "Washing machine: 12 min", "Next bus 8:42", "Rain from 14:00", "Battery 87%",
+};
+
+static GlyphRun runs[8];
+static uint8_t framebuffer[FRAMEBUFFER_SIZE];
+
+/**
+ * @brief Draw the labels glyph by glyph at pseudo random positions.
+ *
+ * @param best Raised to the glyphs per second of this round if faster.
+ */
+static void draw_labels(bool old, uint32_t flags, double *best)
+{
+    FontProperties props = {.fg_color = 0, .bg_color = 15, .flags = flags};
+    uint32_t seed = 1;
+    int64_t glyphs = 0;
+    double start = host_now();
+
+    for (int32_t i = 0; i < DRAWS; i++)
+    {
+        const GlyphRun *run = &runs[i % 8];
+        int32_t x = host_rand(&seed) % 600;
+        int32_t y = 40 + host_rand(&seed) % 480;
+
+        for (int32_t g = 0; g < run->count; g++)
+        {
+            int32_t glyph_x = x + run->glyphs[g].x;
+
+            if (old)
+                old_draw_char(run->font, framebuffer, &glyph_x, y, EPD_WIDTH / 2, EPD_HEIGHT,
+                              run->glyphs[g].glyph, &props);
+            else
+                draw_char(run->font, framebuffer, &glyph_x, y, EPD_WIDTH / 2, EPD_HEIGHT,
+                          run->glyphs[g].glyph, get_style(&props));
+        }
+        glyphs += run->count;
+    }
+    double rate = glyphs / (host_now() - start);
+    *best = rate > *best ? rate : *best;
+}
+
+int main()
+{
+    double rates[2][2] = {{0}};
+
+    for (int32_t i = 0; i < 8; i++)
+        CHECK(layout_text(&FiraSans, labels[i], NULL, &runs[i]));
+    memset(framebuffer, 0xFF, FRAMEBUFFER_SIZE);
+
+    // interleaved, so a busy host slows all of them alike
+    for (int32_t round = 0; round < ROUNDS; round++)
+    {
+        for (int32_t composite = 0; composite < 2; composite++)
+        {
+            draw_labels(true, composite ? DRAW_COMPOSITE : 0, &rates[composite][0]);
+            draw_labels(false, composite ? DRAW_COMPOSITE : 0, &rates[composite][1]);
+        }
+    }
+
+    printf("M glyphs/s   old draw_char   draw_char\n");
+    for (int32_t composite = 0; composite < 2; composite++)
+    {
+        printf("%-10s %15.2f %11.2f  %.1fx\n", composite ? "composite" : "flat", rates[composite][0] / 1e6,
+               rates[composite][1] / 1e6, rates[composite][1] / rates[composite][0]);
+    }
+    for (int32_t i = 0; i < 8; i++)
+        free_glyph_run(&runs[i]);
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file bench_framestore.c
+ * @brief Measure how small the run-length encoded frame store keeps each sample
+ *        page and how fast framebuffer rows compare to it, against comparing to
+ *        a plain copy of the frame with memcmp.
+ */
+
+#include "host.h"
+#include "pages.h"
+
+#include "epd_framestore.h"
+#include "epd_rle.h"
+
+#include <string.h>
+
+#define FRAMEBUFFER_SIZE (EPD_WIDTH / 2 * EPD_HEIGHT)
+#define ROW_BYTES (EPD_WIDTH / 2)
+#define REPEATS 200
+
+static uint8_t shown[FRAMEBUFFER_SIZE];
+static uint8_t next[FRAMEBUFFER_SIZE];
+static uint8_t copy[FRAMEBUFFER_SIZE];
+static uint8_t row[ROW_BYTES];
+
+/**
+ * @brief Get the bytes the store takes for a frame: the rows, encoded or raw
+ *        if that is smaller, their offsets and how each is stored.
+ */
+static size_t stored_size(const uint8_t *framebuffer)
+{
+    size_t size = EPD_HEIGHT * (sizeof(uint32_t) + 1);
+
+    for (int32_t y = 0; y < EPD_HEIGHT; y++)
+    {
+        size_t encoded = epd_rle_encode(&framebuffer[y * ROW_BYTES], ROW_BYTES, NULL);
+
+        size += encoded < ROW_BYTES ? encoded : ROW_BYTES;
+    }
+    return size;
+}
+
+/**
+ * @brief Time comparing every row of `framebuffer` to the stored frame in ms.
+ */
+static double time_diff(const uint8_t *framebuffer, int32_t *changed_rows)
+{
+    double start = host_now();
+
+    for (int32_t i = 0; i < REPEATS; i++)
+    {
+        *changed_rows = 0;
+        for (int32_t y = 0; y < EPD_HEIGHT; y++)
+            *changed_rows += epd_framestore_diff_row(y, &framebuffer[y * ROW_BYTES], 16) != 0;
+    }
+    return (host_now() - start) * 1000 / REPEATS;
+}
+
+/**
+ * @brief Time comparing every row of an unchanged `framebuffer` to a plain copy in ms.
+ */
+static double time_memcmp(const uint8_t *framebuffer, const uint8_t *copy)
+{
+    double start = host_now();
+
+    for (int32_t i = 0; i < REPEATS; i++)
+    {
+        for (int32_t y = 0; y < EPD_HEIGHT; y++)
+            host_sink += memcmp(&framebuffer[y * ROW_BYTES], &copy[y * ROW_BYTES], ROW_BYTES) != 0;
+    }
+    return (host_now() - start) * 1000 / REPEATS;
+}
+
+int main()
+{
+    printf("%-10s %9s %7s %9s %9s %9s %11s %8s\n", "page", "bytes", "ratio", "store ms",
+           "same ms", "label ms", "memcmp ms", "changed");
+    for (SamplePage_t page = 0; page < PAGE_COUNT; page++)
+    {
+        int32_t same_rows, label_rows;
+        double start, store_ms, same_ms, label_ms, memcmp_ms;
+
+        sample_page_draw(page, 0, shown);
+        sample_page_draw(page, 1, next);
+
+        start = host_now();
+        for (int32_t i = 0; i < REPEATS; i++)
+            CHECK(epd_framestore_store(shown));
+        store_ms = (host_now() - start) * 1000 / REPEATS;
+
+        // the store gives back exactly what went in
+        for (int32_t y = 0; y < EPD_HEIGHT; y++)
+        {
+            CHECK(epd_framestore_get_row(y, row));
+            CHECK(memcmp(row, &shown[y * ROW_BYTES], ROW_BYTES) == 0);
+        }
+
+        same_ms = time_diff(shown, &same_rows);
+        label_ms = time_diff(next, &label_rows);
+        memcpy(copy, shown, FRAMEBUFFER_SIZE);
+        memcmp_ms = time_memcmp(shown, copy);
+        CHECK(same_rows == 0);
+        CHECK(stored_size(shown) <= FRAMEBUFFER_SIZE + EPD_HEIGHT * (sizeof(uint32_t) + 1));
+        CHECK(page == PAGE_BLANK ? label_rows == 0 : label_rows > 0);
+
+        printf("%-10s %9zu %6.1fx %9.3f %9.3f %9.3f %11.3f %8d\n", sample_page_name(page),
+               stored_size(shown), (double)FRAMEBUFFER_SIZE / stored_size(shown), store_ms,
+               same_ms, label_ms, memcmp_ms, (int)label_rows);
+    }
+    return 0;
+}
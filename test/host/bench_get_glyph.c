@@ -0,0 +1,125 @@
+/**
+ * @file bench_get_glyph.c
+ * @brief Time `get_glyph` over mixed ASCII, Latin-1, symbol and emoji code
+ *        points against the linear interval scan it replaced, with and
+ *        without the direct index, in FiraSans and in a font of many ranges.
+ *        Checks first that both find the same glyph for every code point of
+ *        the first two planes.
+ */
+
+#include "host.h"
+#include "pages.h"
+
+#define REPEATS 2000000
+#define MANY_INTERVALS 64
+#define INTERVAL_GLYPHS 0x60
+
+static const uint32_t mixed[] = {
+    'H', 'e', 'l', 'l', 'o', ' ', 0xE9, 0x1F600, 'w', 0x2714,
+    'o', 'r', 0x1F680, 'l', 'd', 0xFC, 0x2588, '!', 0x20AC, '5',
+};
+
+static GFXglyph many_glyphs[MANY_INTERVALS * INTERVAL_GLYPHS];
+static UnicodeInterval many_intervals[MANY_INTERVALS];
+static uint16_t many_direct_index[256];
+
+/**
+ * @brief A font of many ranges, like one with CJK or several scripts, ASCII
+ *        first and the others 2048 code points apart. Only the lookup is timed,
+ *        so the glyphs are blank.
+ */
+static GFXfont make_many_font()
+{
+    GFXfont font = {.glyph = many_glyphs, .intervals = many_intervals, .interval_count = MANY_INTERVALS};
+
+    for (int32_t i = 0; i < MANY_INTERVALS; i++)
+    {
+        many_intervals[i].first = i * 0x800 + 0x20;
+        many_intervals[i].last = many_intervals[i].first + INTERVAL_GLYPHS - 1;
+        many_intervals[i].offset = i * INTERVAL_GLYPHS;
+    }
+    for (int32_t code_point = 0; code_point < 256; code_point++)
+    {
+        bool in_first = code_point >= 0x20 && code_point < 0x20 + INTERVAL_GLYPHS;
+        many_direct_index[code_point] = in_first ? code_point - 0x20 : GLYPH_INDEX_NONE;
+    }
+    return font;
+}
+
+/**
+ * @brief The linear scan over the intervals `get_glyph` used to do, as the reference.
+ */
+static void linear_get_glyph(const GFXfont *font, uint32_t code_point, GFXglyph **glyph)
+{
+    UnicodeInterval *intervals = font->intervals;
+    *glyph = NULL;
+    for (uint32_t i = 0; i < font->interval_count; i++)
+    {
+        UnicodeInterval *interval = &intervals[i];
+        if (code_point >= interval->first && code_point <= interval->last)
+        {
+            *glyph = &font->glyph[interval->offset + (code_point - interval->first)];
+            return;
+        }
+        if (code_point < interval->first)
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Lookups per second over the mixed code points.
+ */
+__attribute__((noinline)) static double time_lookups(const GFXfont *font, void (*lookup)(const GFXfont *, uint32_t, GFXglyph **))
+{
+    const int32_t count = sizeof(mixed) / sizeof(mixed[0]);
+    GFXglyph *glyph;
+    double start = host_now();
+
+    for (int32_t r = 0; r < REPEATS; r++)
+    {
+        for (int32_t i = 0; i < count; i++)
+        {
+            lookup(font, mixed[i], &glyph);
+            host_sink += glyph != NULL;
+        }
+    }
+    return (double)REPEATS * count / (host_now() - start);
+}
+
+/**
+ * @brief Check the lookup against the linear scan, then time all three.
+ */
+static void run_font(const char *name, const GFXfont *font)
+{
+    GFXfont no_index = *font;
+
+    no_index.direct_index = NULL;
+    no_index.direct_count = 0;
+    for (uint32_t code_point = 0; code_point < 0x20000; code_point++)
+    {
+        GFXglyph *expected, *glyph;
+
+        linear_get_glyph(font, code_point, &expected);
+        get_glyph(font, code_point, &glyph);
+        CHECK(glyph == expected);
+        get_glyph(&no_index, code_point, &glyph);
+        CHECK(glyph == expected);
+    }
+
+    printf("%-10s %14.1f %14.1f %14.1f\n", name, time_lookups(font, linear_get_glyph) / 1e6,
+           time_lookups(&no_index, get_glyph) / 1e6, time_lookups(font, get_glyph) / 1e6);
+}
+
+int main()
+{
+    GFXfont many = make_many_font();
+
+    many.direct_index = many_direct_index;
+    many.direct_count = 256;
+    printf("M lookups/s %13s %14s %14s\n", "linear scan", "binary search", "direct index");
+    run_font("FiraSans", &FiraSans);
+    run_font("64 ranges", &many);
+    return 0;
+}
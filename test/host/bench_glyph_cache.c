@@ -0,0 +1,120 @@
+/**
+ * @file bench_glyph_cache.c
+ * @brief Glyphs per second through the glyph cache cold, cleared before every
+ *        label, and warm, against decompressing every glyph, then check the
+ *        cache against zlib while it evicts.
+ */
+
+#include "host.h"
+#include "pages.h"
+
+#include "epd_glyph_cache.h"
+#include "zlib/zlib.h"
+
+#include <string.h>
+
+#define REPEATS 20000
+
+static const char *const label = "Living room 21.5 C Humidity 45% ";
+
+static const GFXglyph *label_glyph(int32_t i)
+{
+    return &FiraSans.glyph[label[i] - 0x20];
+}
+
+/**
+ * @brief Glyphs per second decompressing every glyph, as before the cache.
+ */
+static double time_uncached(int32_t length)
+{
+    static uint8_t bitmap[8192];
+    double start = host_now();
+
+    for (int32_t r = 0; r < REPEATS; r++)
+    {
+        for (int32_t i = 0; i < length; i++)
+        {
+            const GFXglyph *glyph = label_glyph(i);
+            uLongf size = sizeof(bitmap);
+
+            if (glyph->width)
+                uncompress(bitmap, &size, &FiraSans.bitmap[glyph->data_offset], glyph->compressed_size);
+            host_sink += bitmap[0];
+        }
+    }
+    return (double)REPEATS * length / (host_now() - start);
+}
+
+/**
+ * @brief Glyphs per second through the cache.
+ *
+ * @param cold Clear the cache before every label.
+ */
+static double time_cached(int32_t length, bool cold)
+{
+    double start = host_now();
+
+    for (int32_t r = 0; r < REPEATS; r++)
+    {
+        if (cold)
+            epd_glyph_cache_clear();
+        for (int32_t i = 0; i < length; i++)
+            host_sink += epd_glyph_cache_get(&FiraSans, label_glyph(i))[0];
+    }
+    return (double)REPEATS * length / (host_now() - start);
+}
+
+/**
+ * @brief Walk all glyphs in a scattered order a few times, far more than fit,
+ *        and compare every bitmap the cache hands out with zlib's.
+ */
+static void check_eviction()
+{
+    int32_t total = 0;
+    GlyphCacheStats_t stats;
+
+    for (uint32_t i = 0; i < FiraSans.interval_count; i++)
+        total += FiraSans.intervals[i].last - FiraSans.intervals[i].first + 1;
+
+    epd_glyph_cache_clear();
+    for (int32_t r = 0; r < 5; r++)
+    {
+        for (int32_t i = 0; i < total; i++)
+        {
+            const GFXglyph *glyph = &FiraSans.glyph[(i * 37) % total];
+            const uint8_t *bitmap = epd_glyph_cache_get(&FiraSans, glyph);
+            static uint8_t expected[8192];
+            uLongf size = sizeof(expected);
+
+            if (glyph->width == 0 || glyph->height == 0)
+                continue;
+            CHECK(uncompress(expected, &size, &FiraSans.bitmap[glyph->data_offset], glyph->compressed_size) == Z_OK);
+            CHECK(bitmap != NULL && memcmp(bitmap, expected, size) == 0);
+        }
+    }
+    epd_glyph_cache_get_stats(&stats);
+    CHECK(stats.evictions > 0);
+    CHECK(stats.bytes <= EPD_GLYPH_CACHE_BYTES && stats.entries <= EPD_GLYPH_CACHE_ENTRIES);
+    printf("eviction: %u hits, %u misses, %u evictions, %d entries, %zu bytes\n", stats.hits,
+           stats.misses, stats.evictions, (int)stats.entries, stats.bytes);
+}
+
+int main()
+{
+    int32_t length = strlen(label);
+    double uncached, cold, warm;
+    GlyphCacheStats_t stats;
+
+    uncached = time_uncached(length);
+    cold = time_cached(length, true);
+    epd_glyph_cache_clear();
+    warm = time_cached(length, false);
+    epd_glyph_cache_get_stats(&stats);
+    printf("uncached %10.0f glyphs/s\n", uncached);
+    printf("cold     %10.0f glyphs/s\n", cold);
+    printf("warm     %10.0f glyphs/s, %u hits, %u misses\n", warm, stats.hits, stats.misses);
+
+    check_eviction();
+    epd_glyph_cache_clear();
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file bench_text.c
+ * @brief Compare the glyph throughput of composite text, blended into what is
+ *        under it, with flat text drawn glyph by glyph and from the text cache.
+ *        Fails when composite text falls below `COMPOSITE_MIN_PERCENT` of flat
+ *        text drawn glyph by glyph.
+ */
+
+#include "host.h"
+#include "pages.h"
+
+#include "epd_text_cache.h"
+
+#include <string.h>
+
+#define FRAMEBUFFER_SIZE (EPD_WIDTH / 2 * EPD_HEIGHT)
+#define DRAWS 20000
+#define ROUNDS 5
+
+/**
+ * @brief The slowest composite text may be, in percent of flat text.
+ */
+#define COMPOSITE_MIN_PERCENT 90
+
+static const char *const labels[] = {
+    "Living room", "21.5 °C", "Humidity 45%", "Front door locked",
+    "Washing machine: 12 min", "Next bus 8:42", "Rain from 14:00", "Battery 87%",
+};
+
+static uint8_t framebuffer[FRAMEBUFFER_SIZE];
+static uint8_t expected[FRAMEBUFFER_SIZE];
+
+/**
+ * @brief Count the glyphs of a UTF-8 string.
+ */
+static int32_t glyph_count(const char *text)
+{
+    int32_t count = 0;
+
+    for (; *text; text++)
+        count += (*text & 0xC0) != 0x80;
+    return count;
+}
+
+/**
+ * @brief Draw labels at pseudo random positions, odd and even columns alike.
+ *
+ * @param best Raised to the glyphs per second of this round if faster.
+ */
+static void draw_labels(uint32_t flags, uint8_t *buffer, double *best)
+{
+    FontProperties props = {.fg_color = 0, .bg_color = 15, .flags = flags};
+    uint32_t seed = 1;
+    int64_t glyphs = 0;
+    double start = host_now();
+
+    for (int32_t i = 0; i < DRAWS; i++)
+    {
+        const char *text = labels[i % 8];
+        int32_t x = host_rand(&seed) % 600;
+        int32_t y = 40 + host_rand(&seed) % 480;
+
+        write_mode(&FiraSans, text, &x, &y, buffer, BLACK_ON_WHITE, &props);
+        glyphs += glyph_count(text);
+    }
+    double rate = glyphs / (host_now() - start);
+    *best = rate > *best ? rate : *best;
+}
+
+/**
+ * @brief Check that composite text over white comes out as flat text, so both
+ *        paths do the same work.
+ */
+static void check_composite_over_white()
+{
+    FontProperties flat = {.fg_color = 0, .bg_color = 15};
+    FontProperties composite = {.fg_color = 0, .bg_color = 15, .flags = DRAW_COMPOSITE};
+
+    for (int32_t x0 = 100; x0 < 102; x0++)
+    {
+        int32_t x = x0, y = 100;
+
+        memset(expected, 0xFF, FRAMEBUFFER_SIZE);
+        write_mode(&FiraSans, labels[4], &x, &y, expected, BLACK_ON_WHITE, &flat);
+        x = x0;
+        memset(framebuffer, 0xFF, FRAMEBUFFER_SIZE);
+        write_mode(&FiraSans, labels[4], &x, &y, framebuffer, BLACK_ON_WHITE, &composite);
+        CHECK(memcmp(framebuffer, expected, FRAMEBUFFER_SIZE) == 0);
+    }
+}
+
+int main()
+{
+    double cached = 0, flat = 0, composite = 0;
+    TextCacheStats_t stats;
+
+    check_composite_over_white();
+    memset(framebuffer, 0xFF, FRAMEBUFFER_SIZE);
+    epd_text_cache_clear();
+
+    // interleaved, so a busy host slows all three alike
+    for (int32_t round = 0; round < ROUNDS; round++)
+    {
+        draw_labels(0, framebuffer, &cached);
+        draw_labels(DRAW_BACKGROUND, framebuffer, &flat);
+        draw_labels(DRAW_COMPOSITE, framebuffer, &composite);
+    }
+
+    epd_text_cache_get_stats(&stats);
+    printf("flat cached      %10.0f glyphs/s, %u hits, %u misses, %u evictions, %d runs in %zu bytes\n",
+           cached, (unsigned)stats.hits, (unsigned)stats.misses, (unsigned)stats.evictions, (int)stats.entries,
+           stats.bytes);
+    printf("flat per glyph   %10.0f glyphs/s\n", flat);
+    printf("composite        %10.0f glyphs/s, %.0f%% of flat per glyph\n", composite,
+           composite * 100 / flat);
+    if (composite * 100 < flat * COMPOSITE_MIN_PERCENT)
+    {
+        printf("composite text is below %d%% of flat text\n", COMPOSITE_MIN_PERCENT);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file bench_tiles.c
+ * @brief Time finding the changed tiles of a whole framebuffer, the scan every
+ *        frame pays, on each sample page: unchanged and with one label changed.
+ */
+
+#include "host.h"
+#include "pages.h"
+
+#include "epd_tiles.h"
+
+#define FRAMEBUFFER_SIZE (EPD_WIDTH / 2 * EPD_HEIGHT)
+#define SCANS 200
+
+static uint8_t shown[FRAMEBUFFER_SIZE];
+static uint8_t next[FRAMEBUFFER_SIZE];
+
+/**
+ * @brief Time the scan of `framebuffer` against the committed frame in ms.
+ */
+static double time_scan(const uint8_t *framebuffer, int32_t *changed_tiles)
+{
+    TileMask_t changed;
+    double start = host_now();
+
+    for (int32_t i = 0; i < SCANS; i++)
+        *changed_tiles = epd_tiles_find_changed(framebuffer, changed);
+    return (host_now() - start) * 1000 / SCANS;
+}
+
+int main()
+{
+    printf("%-10s %10s %10s %12s %10s %12s\n", "page", "commit ms", "same ms",
+           "same MB/s", "label ms", "label tiles");
+    for (SamplePage_t page = 0; page < PAGE_COUNT; page++)
+    {
+        int32_t same_tiles, label_tiles;
+        double start, commit_ms, same_ms, label_ms;
+
+        sample_page_draw(page, 0, shown);
+        sample_page_draw(page, 1, next);
+
+        start = host_now();
+        for (int32_t i = 0; i < SCANS; i++)
+            epd_tiles_commit(shown);
+        commit_ms = (host_now() - start) * 1000 / SCANS;
+
+        same_ms = time_scan(shown, &same_tiles);
+        label_ms = time_scan(next, &label_tiles);
+        CHECK(same_tiles == 0);
+        CHECK(page == PAGE_BLANK ? label_tiles == 0 : label_tiles > 0);
+
+        printf("%-10s %10.3f %10.3f %12.0f %10.3f %12d\n", sample_page_name(page), commit_ms,
+               same_ms, FRAMEBUFFER_SIZE / same_ms / 1000, label_ms, (int)label_tiles);
+    }
+    return 0;
+}
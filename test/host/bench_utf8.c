@@ -0,0 +1,38 @@
+/**
+ * @file bench_utf8.c
+ * @brief Decoding throughput of `next_cp` from font.c on label text against
+ *        the old table driven decoder.
+ */
+
+#include "font.c"
+
+#include "host.h"
+#include "utf8_old.h"
+
+#define REPEATS 2000000
+
+static const char *const text = "Living room 21.5 \xC2\xB0" "C, humidity 45% \xE2\x9C\x94 next bus in 4 min \xF0\x9F\x9A\x80 ";
+
+/**
+ * @brief Megabytes per second through a decoder.
+ */
+__attribute__((noinline)) static double time_decoder(uint32_t (*decode)(const uint8_t **))
+{
+    double start = host_now();
+
+    for (int32_t r = 0; r < REPEATS; r++)
+    {
+        const uint8_t *p = (const uint8_t *)text;
+        uint32_t c;
+        while ((c = decode(&p)))
+            host_sink += c;
+    }
+    return (double)REPEATS * strlen(text) / (host_now() - start) / 1e6;
+}
+
+int main()
+{
+    printf("old decoder %8.0f MB/s\n", time_decoder(old_next_cp));
+    printf("next_cp     %8.0f MB/s\n", time_decoder(next_cp));
+    return 0;
+}
@@ -0,0 +1,233 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "codecs.h"
+#include "host.h"
+#include "pages.h"
+
+#include "zlib.h"
+
+#include <string.h>
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+static const char *const codec_names[] = {"none", "zlib", "rle", "deflate"};
+
+static uint8_t **unpacked = NULL;
+
+static GFXfont fonts[4];
+static bool built[4];
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+static uint32_t unpacked_size(const GFXglyph *glyph)
+{
+    return (glyph->width + 1) / 2 * glyph->height;
+}
+
+static void unpack_all()
+{
+    uint32_t count = codec_glyph_count();
+
+    unpacked = calloc(count, sizeof(uint8_t *));
+    CHECK(unpacked != NULL && FiraSans.compressed == GLYPH_CODEC_ZLIB);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const GFXglyph *glyph = &FiraSans.glyph[i];
+        uLongf size = unpacked_size(glyph);
+
+        unpacked[i] = malloc(size + 1);
+        CHECK(unpacked[i] != NULL);
+        if (size > 0)
+        {
+            CHECK(uncompress(unpacked[i], &size, &FiraSans.bitmap[glyph->data_offset], glyph->compressed_size) == Z_OK);
+            CHECK(size == unpacked_size(glyph));
+        }
+    }
+}
+
+static uint8_t pixel_at(const uint8_t *packed, size_t p)
+{
+    return (packed[p / 2] >> (4 * (p % 2))) & 0x0F;
+}
+
+static void put_nibble(uint8_t *out, size_t *n, uint8_t value)
+{
+    if (*n % 2)
+        out[*n / 2] |= value << 4;
+    else
+        out[*n / 2] = value;
+    (*n)++;
+}
+
+/**
+ * @brief Blank and full pixels are worth a run from two on.
+ */
+static bool starts_run(const uint8_t *packed, size_t count, size_t p)
+{
+    uint8_t value = pixel_at(packed, p);
+
+    return (value == 0x0 || value == 0xF) && (p + 1 == count || pixel_at(packed, p + 1) == value);
+}
+
+/**
+ * @brief Encode a bitmap as `GLYPH_CODEC_RLE`, like `rle_compress` of
+ *        fontconvert.py.
+ *
+ * @param out Room for `3 * size + 1` bytes, a token per pixel at worst.
+ *
+ * @return The encoded size.
+ */
+static size_t rle_encode(const uint8_t *packed, size_t size, uint8_t *out)
+{
+    size_t count = 2 * size;
+    size_t n = 0;
+
+    for (size_t p = 0; p < count;)
+    {
+        uint8_t value = 0;
+        uint32_t run = 0;
+        uint8_t literals[3];
+        uint32_t literal_count = 0;
+
+        if (pixel_at(packed, p) == 0x0 || pixel_at(packed, p) == 0xF)
+        {
+            value = pixel_at(packed, p);
+            while (p < count && pixel_at(packed, p) == value && run < 31)
+            {
+                run++;
+                p++;
+            }
+        }
+        while (p < count && literal_count < 3 && !starts_run(packed, count, p))
+            literals[literal_count++] = pixel_at(packed, p++);
+
+        uint8_t token = (value == 0xF ? 0x80 : 0) | run << 2 | literal_count;
+        put_nibble(out, &n, token & 0x0F);
+        put_nibble(out, &n, token >> 4);
+        for (uint32_t i = 0; i < literal_count; i++)
+            put_nibble(out, &n, literals[i]);
+    }
+    return (n + 1) / 2;
+}
+
+/**
+ * @brief Encode a bitmap as `GLYPH_CODEC_DEFLATE`, at the default level like
+ *        `zlib.compressobj(wbits=-15)`.
+ *
+ * @param out Room for `deflateBound` bytes.
+ *
+ * @return The encoded size.
+ */
+static size_t deflate_raw(const uint8_t *packed, size_t size, uint8_t *out, size_t out_size)
+{
+    z_stream stream;
+
+    memset(&stream, 0, sizeof(stream));
+    CHECK(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+    stream.next_in = (Bytef *)packed;
+    stream.avail_in = size;
+    stream.next_out = out;
+    stream.avail_out = out_size;
+    CHECK(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+    size_t encoded = stream.total_out;
+    deflateEnd(&stream);
+    return encoded;
+}
+
+static void build_font(enum GlyphCodec codec, GFXfont *font)
+{
+    uint32_t count = codec_glyph_count();
+    size_t capacity = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+        capacity += 3 * unpacked_size(&FiraSans.glyph[i]) + 64;
+
+    GFXglyph *glyphs = malloc(count * sizeof(GFXglyph));
+    uint8_t *bitmap = malloc(capacity);
+    CHECK(glyphs != NULL && bitmap != NULL);
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t size = unpacked_size(&FiraSans.glyph[i]);
+        size_t encoded = size;
+
+        if (codec == GLYPH_CODEC_RLE)
+            encoded = rle_encode(unpacked[i], size, &bitmap[offset]);
+        else if (codec == GLYPH_CODEC_DEFLATE)
+            encoded = deflate_raw(unpacked[i], size, &bitmap[offset], capacity - offset);
+        else
+            memcpy(&bitmap[offset], unpacked[i], size);
+        CHECK(encoded <= UINT16_MAX);
+
+        glyphs[i] = FiraSans.glyph[i];
+        glyphs[i].data_offset = offset;
+        glyphs[i].compressed_size = codec == GLYPH_CODEC_NONE ? 0 : encoded;
+        offset += encoded;
+    }
+
+    *font = FiraSans;
+    font->bitmap = bitmap;
+    font->glyph = glyphs;
+    font->compressed = codec;
+}
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+uint32_t codec_glyph_count()
+{
+    const UnicodeInterval *last = &FiraSans.intervals[FiraSans.interval_count - 1];
+
+    return last->offset + last->last - last->first + 1;
+}
+
+
+const uint8_t *codec_unpacked(uint32_t index)
+{
+    if (unpacked == NULL)
+        unpack_all();
+    return unpacked[index];
+}
+
+
+const GFXfont *codec_font(enum GlyphCodec codec)
+{
+    if (codec == GLYPH_CODEC_ZLIB)
+        return &FiraSans;
+    if (unpacked == NULL)
+        unpack_all();
+    if (!built[codec])
+    {
+        build_font(codec, &fonts[codec]);
+        built[codec] = true;
+    }
+    return &fonts[codec];
+}
+
+
+size_t codec_flash_bytes(const GFXfont *font)
+{
+    size_t bytes = 0;
+
+    for (uint32_t i = 0; i < codec_glyph_count(); i++)
+    {
+        const GFXglyph *glyph = &font->glyph[i];
+
+        bytes += font->compressed == GLYPH_CODEC_NONE ? unpacked_size(glyph) : glyph->compressed_size;
+    }
+    return bytes;
+}
+
+
+const char *codec_name(enum GlyphCodec codec)
+{
+    return codec_names[codec];
+}
@@ -0,0 +1,44 @@
+/**
+ * @file codecs.h
+ * @brief FiraSans with its glyphs encoded in each `GlyphCodec`, built from the
+ *        zlib font the sample pages use, the way scripts/fontconvert.py
+ *        encodes them.
+ */
+
+#ifndef _CODECS_H_
+#define _CODECS_H_
+
+#include "epd_driver.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Get the number of glyphs of FiraSans.
+ */
+uint32_t codec_glyph_count();
+
+/**
+ * @brief Get a glyph bitmap of FiraSans, unpacked with zlib itself.
+ *
+ * @return `(width + 1) / 2` bytes per row.
+ */
+const uint8_t *codec_unpacked(uint32_t index);
+
+/**
+ * @brief Get FiraSans with its glyphs encoded in `codec`. The font stays
+ *        valid until exit.
+ */
+const GFXfont *codec_font(enum GlyphCodec codec);
+
+/**
+ * @brief Get the bytes the glyph bitmaps of a font take in flash.
+ */
+size_t codec_flash_bytes(const GFXfont *font);
+
+/**
+ * @brief Get the name of a codec for reports.
+ */
+const char *codec_name(enum GlyphCodec codec);
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @file draw_char_old.h
+ * @brief The pixel at a time `draw_char` font.c used before glyph styles and
+ *        `blit_row`, kept as the reference for glyph drawing. Include after
+ *        font.c.
+ *
+ * The old loop started at the first glyph column even when that column was
+ * left of the buffer, reading and writing outside it. Here the columns are
+ * clipped as the glyph row is meant to be: the buffer column and the glyph
+ * column advance together from the first one inside the buffer.
+ */
+
+#ifndef _DRAW_CHAR_OLD_H_
+#define _DRAW_CHAR_OLD_H_
+
+#include "epd_driver.h"
+#include "epd_glyph_cache.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+static void old_draw_char(const GFXfont *font, uint8_t *buffer, int32_t *cursor_x, int32_t cursor_y,
+                          uint16_t buf_width, uint16_t buf_height, const GFXglyph *glyph,
+                          const FontProperties *props)
+{
+    if (!glyph)
+    {
+        return;
+    }
+
+    uint8_t width = glyph->width;
+    uint8_t height = glyph->height;
+    int32_t left = glyph->left;
+
+    int32_t byte_width = (width / 2 + width % 2);
+    const uint8_t *bitmap = epd_glyph_cache_get(font, glyph);
+    if (bitmap == NULL)
+    {
+        *cursor_x += glyph->advance_x;
+        return;
+    }
+
+    uint8_t color_lut[16];
+    for (int32_t c = 0; c < 16; c++)
+    {
+        int32_t color_difference = (int32_t)props->fg_color - (int32_t)props->bg_color;
+        color_lut[c] = max(0, min(15, props->bg_color + c * color_difference / 15));
+    }
+
+    // blend_lut[coverage][destination], only built when compositing
+    bool composite = props->flags & DRAW_COMPOSITE;
+    uint8_t blend_lut[16][16];
+    if (composite)
+    {
+        for (int32_t c = 0; c < 16; c++)
+        {
+            for (int32_t d = 0; d < 16; d++)
+            {
+                int32_t color_difference = (int32_t)props->fg_color - d;
+                blend_lut[c][d] = d + (c * color_difference + (color_difference < 0 ? -7 : 7)) / 15;
+            }
+        }
+    }
+
+    for (int32_t y = 0; y < height; y++)
+    {
+        int32_t yy = cursor_y - glyph->top + y;
+        if (yy < 0 || yy >= buf_height)
+        {
+            continue;
+        }
+        int32_t start_pos = *cursor_x + left;
+        int32_t x = max(0, -start_pos);
+        int32_t max_x = min(start_pos + width, buf_width * 2);
+        for (int32_t xx = start_pos + x; xx < max_x; xx++)
+        {
+            uint32_t buf_pos = yy * buf_width + xx / 2;
+            uint8_t old = buffer[buf_pos];
+            uint8_t bm = bitmap[y * byte_width + x / 2];
+            if ((x & 1) == 0)
+            {
+                bm = bm & 0xF;
+            }
+            else
+            {
+                bm = bm >> 4;
+            }
+
+            if ((xx & 1) == 0)
+            {
+                uint8_t color = composite ? blend_lut[bm][old & 0x0F] : color_lut[bm];
+                buffer[buf_pos] = (old & 0xF0) | color;
+            }
+            else
+            {
+                uint8_t color = composite ? blend_lut[bm][old >> 4] : color_lut[bm];
+                buffer[buf_pos] = (old & 0x0F) | (color << 4);
+            }
+            x++;
+        }
+    }
+    *cursor_x += glyph->advance_x;
+}
+
+#endif
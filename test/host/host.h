@@ -0,0 +1,52 @@
+/**
+ * @file host.h
+ * @brief Helpers shared by the host tests and benchmarks.
+ */
+
+#ifndef _HOST_H_
+#define _HOST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief Fail the test with the source location if a condition is false.
+ */
+#define CHECK(condition)                                                     \
+    do                                                                       \
+    {                                                                        \
+        if (!(condition))                                                    \
+        {                                                                    \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, \
+                    #condition);                                             \
+            exit(1);                                                         \
+        }                                                                    \
+    } while (0)
+
+/**
+ * @brief Monotonic time in seconds.
+ */
+static inline double host_now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief A fixed sequence of pseudo random numbers, so runs are comparable.
+ */
+static inline uint32_t host_rand(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/**
+ * @brief Keeps benchmark results alive so the compiler can't drop the work.
+ */
+extern volatile uint32_t host_sink;
+
+#endif
@@ -0,0 +1,128 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "pages.h"
+#include "host.h"
+
+#include "epd_driver.h"
+#include "firasans.h"
+
+#include <string.h>
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+static const char *const page_names[PAGE_COUNT] = {
+    "blank", "dashboard", "player", "text", "photo",
+};
+
+static const char *const labels[] = {
+    "Living room", "21.5 °C", "Humidity 45%", "Kitchen", "Lights on",
+    "Bedroom", "19.0 °C", "Front door locked", "Washing machine: 12 min",
+    "Next bus 8:42", "Rain from 14:00", "Battery 87%",
+};
+
+/******************************************************************************/
+/***        local functions                                                 ***/
+/******************************************************************************/
+
+static void draw_label(const char *text, int32_t x, int32_t y, uint8_t *framebuffer)
+{
+    writeln(&FiraSans, text, &x, &y, framebuffer);
+}
+
+static void draw_dashboard(int32_t variant, uint8_t *framebuffer)
+{
+    char value[32];
+
+    for (int32_t i = 0; i < 12; i++)
+    {
+        int32_t x = 20 + (i % 3) * 310;
+        int32_t y = 40 + (i / 3) * 120;
+
+        epd_draw_rect(x, y, 290, 100, 0x00, framebuffer);
+        draw_label(labels[i], x + 16, y + 45, framebuffer);
+    }
+    snprintf(value, sizeof(value), "Updated %02d:%02d", 12 + variant / 60, variant % 60);
+    draw_label(value, 20, 530, framebuffer);
+    epd_fill_rect(700, 495, 240, 40, 0x00, framebuffer);
+}
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+const char *sample_page_name(SamplePage_t page)
+{
+    return page_names[page];
+}
+
+void sample_image(int32_t width, int32_t height, uint32_t seed, uint8_t *image)
+{
+    int32_t stride = (width + 1) / 2;
+
+    memset(image, 0, stride * height);
+    for (int32_t y = 0; y < height; y++)
+    {
+        for (int32_t x = 0; x < width; x++)
+        {
+            int32_t level = x * 200 / width + y * 56 / height + (int32_t)(host_rand(&seed) % 32) - 16;
+            uint8_t color = level < 0 ? 0 : level > 255 ? 15 : level / 16;
+
+            image[y * stride + x / 2] |= x % 2 ? color << 4 : color;
+        }
+    }
+}
+
+void sample_page_draw(SamplePage_t page, int32_t variant, uint8_t *framebuffer)
+{
+    static uint8_t image[EPD_WIDTH / 2 * EPD_HEIGHT];
+
+    memset(framebuffer, 0xFF, EPD_WIDTH / 2 * EPD_HEIGHT);
+    switch (page)
+    {
+    case PAGE_BLANK:
+        break;
+    case PAGE_DASHBOARD:
+        draw_dashboard(variant, framebuffer);
+        break;
+    case PAGE_PLAYER:
+        draw_dashboard(variant, framebuffer);
+        epd_fill_rect(20, 160, 920, 340, 0xFF, framebuffer);
+        sample_image(300, 300, 7, image);
+        epd_blit((Rect_t){.x = 30, .y = 180, .width = 300, .height = 300}, image, framebuffer, 0, 0);
+        draw_label("Some Artist", 360, 260, framebuffer);
+        draw_label("A Song Title That Is Long", 360, 320, framebuffer);
+        epd_fill_rect(360, 400, 500, 8, 0x88, framebuffer);
+        epd_fill_rect(360, 400, 180 + variant, 8, 0x00, framebuffer);
+        break;
+    case PAGE_TEXT:
+        for (int32_t line = 0; line < 18; line++)
+        {
+            char text[96];
+            uint32_t seed = line + 1;
+            int32_t length = 0;
+
+            while (length < 80)
+            {
+                const char *word = labels[host_rand(&seed) % 12];
+
+                length += snprintf(text + length, sizeof(text) - length, "%s ", word);
+            }
+            text[80] = '\0';
+            if (line == 9)
+                snprintf(text, sizeof(text), "Line %d changed", (int)variant);
+            draw_label(text, 10, 30 + line * 29, framebuffer);
+        }
+        break;
+    case PAGE_PHOTO:
+        sample_image(EPD_WIDTH, EPD_HEIGHT, 3, image);
+        memcpy(framebuffer, image, EPD_WIDTH / 2 * EPD_HEIGHT);
+        draw_label(labels[variant % 12], 40, 500, framebuffer);
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ * @file pages.h
+ * @brief Sample pages the host benchmarks measure against, drawn with the
+ *        driver itself so they have the runs and text of real screens.
+ */
+
+#ifndef _PAGES_H_
+#define _PAGES_H_
+
+#include "epd_driver.h"
+
+#include <stdint.h>
+
+/**
+ * @brief The font the firmware compiles in, defined by firasans.h in pages.c.
+ */
+extern const GFXfont FiraSans;
+
+/**
+ * @brief The sample pages, from easiest to hardest to compress.
+ */
+typedef enum
+{
+    PAGE_BLANK,     /** A white screen. */
+    PAGE_DASHBOARD, /** Labels and buttons on white, like the server display. */
+    PAGE_PLAYER,    /** A dashboard with 300x300 album art. */
+    PAGE_TEXT,      /** Text lines filling the screen. */
+    PAGE_PHOTO,     /** A dithered gradient over the whole screen. */
+    PAGE_COUNT,
+} SamplePage_t;
+
+/**
+ * @brief Get the name of a page for reports.
+ */
+const char *sample_page_name(SamplePage_t page);
+
+/**
+ * @brief Draw a page into a framebuffer. The same page always comes out the same.
+ *
+ * @param variant Changes one label, for pages that differ a little from the last.
+ */
+void sample_page_draw(SamplePage_t page, int32_t variant, uint8_t *framebuffer);
+
+/**
+ * @brief Fill an image with a dithered gradient, as album art or a photo.
+ *
+ * @param image Rows of `(width + 1) / 2` bytes.
+ */
+void sample_image(int32_t width, int32_t height, uint32_t seed, uint8_t *image);
+
+#endif
@@ -0,0 +1,152 @@
+/******************************************************************************/
+/***        include files                                                   ***/
+/******************************************************************************/
+
+#include "epd_driver.h"
+#include "ed047tc1.h"
+#include "host.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+/******************************************************************************/
+/***        local variables                                                 ***/
+/******************************************************************************/
+
+/**
+ * @brief Stands in for the line buffer the panel driver shifts out.
+ */
+static uint8_t line_buffer[EPD_WIDTH / 2];
+
+/**
+ * @brief Any non-NULL handle, nothing is ever waited on.
+ */
+static int handle;
+
+/******************************************************************************/
+/***        exported functions                                              ***/
+/******************************************************************************/
+
+/*
+ * The panel: nothing is driven on the host, rows are dropped.
+ */
+
+void epd_base_init(uint32_t epd_row_width)
+{
+    (void)epd_row_width;
+}
+
+void epd_poweron() {}
+
+void epd_poweroff() {}
+
+void epd_start_frame() {}
+
+void epd_end_frame() {}
+
+void epd_output_row(uint32_t output_time_dus)
+{
+    (void)output_time_dus;
+}
+
+void epd_skip() {}
+
+uint8_t *epd_get_current_buffer()
+{
+    return line_buffer;
+}
+
+void epd_switch_buffer() {}
+
+/*
+ * FreeRTOS: tasks never run and blocking calls return at once, enough to link
+ * the drawing code. Host tests must not drive the panel.
+ */
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    (void)length;
+    (void)item_size;
+    return &handle;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    (void)queue;
+    (void)item;
+    (void)wait;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    (void)queue;
+    (void)item;
+    (void)wait;
+    return pdFALSE;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    (void)queue;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return &handle;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return &handle;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t wait)
+{
+    (void)semaphore;
+    (void)wait;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    (void)semaphore;
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    (void)semaphore;
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void *), const char *name, uint32_t stack, void *param,
+                                   UBaseType_t priority, TaskHandle_t *handle_out, BaseType_t core)
+{
+    (void)task;
+    (void)name;
+    (void)stack;
+    (void)param;
+    (void)priority;
+    (void)core;
+    if (handle_out)
+        *handle_out = &handle;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    (void)task;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    (void)ticks;
+}
+
+/*
+ * Shared by the tests, see host.h.
+ */
+
+volatile uint32_t host_sink;
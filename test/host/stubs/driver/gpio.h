@@ -0,0 +1,4 @@
+/* Host stand-in for the ESP-IDF header of the same name. */
+#pragma once
+
+typedef int gpio_num_t;
@@ -0,0 +1,5 @@
+/* Host stand-in for the ESP-IDF header of the same name. */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
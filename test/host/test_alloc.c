@@ -0,0 +1,145 @@
+/**
+ * @file test_alloc.c
+ * @brief Check that drawing text does not touch the heap once `epd_font_init`
+ *        has run: the sample pages, strings longer than a stack run, glyph and
+ *        text cache misses and evictions, and text drawn without a
+ *        framebuffer. Cached and compacted text must draw like fresh text.
+ *
+ * The linker wraps malloc and calloc to count the calls, heap_caps_malloc is
+ * malloc on the host.
+ */
+
+#include "host.h"
+#include "pages.h"
+
+#include "epd_glyph_cache.h"
+#include "epd_text_cache.h"
+
+#include <string.h>
+
+#define FRAMEBUFFER_SIZE (EPD_WIDTH / 2 * EPD_HEIGHT)
+
+static const char *const long_line =
+    "The quick brown fox jumps over the lazy dog, then naps in the sun at 21.5 °C until 14:00.";
+
+static uint8_t framebuffer[FRAMEBUFFER_SIZE];
+static uint8_t expected[FRAMEBUFFER_SIZE];
+
+static uint32_t allocations = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+/**
+ * @brief Draw numbers at pseudo random positions, each one new to the text
+ *        cache, to evict and compact the runs cached before.
+ */
+static void draw_numbers(uint32_t *seed, int32_t count)
+{
+    char label[16];
+
+    for (int32_t i = 0; i < count; i++)
+    {
+        int32_t x = host_rand(seed) % (EPD_WIDTH - 200);
+        int32_t y = 40 + host_rand(seed) % (EPD_HEIGHT - 80);
+
+        snprintf(label, sizeof(label), "%u", (unsigned)(host_rand(seed) % 1000000));
+        writeln(&FiraSans, label, &x, &y, framebuffer);
+    }
+}
+
+/**
+ * @brief Get every glyph of the font, more than the glyph cache holds.
+ */
+static void walk_glyphs()
+{
+    const UnicodeInterval *last = &FiraSans.intervals[FiraSans.interval_count - 1];
+    uint32_t total = last->offset + last->last - last->first + 1;
+
+    for (uint32_t i = 0; i < total; i++)
+        host_sink += epd_glyph_cache_get(&FiraSans, &FiraSans.glyph[i]) != NULL;
+}
+
+/**
+ * @brief Draw the long line as one run from `layout_text` and through
+ *        `write_mode`, which draws it in stack sized runs.
+ */
+static void check_long_line(uint32_t flags)
+{
+    FontProperties props = {.fg_color = 0, .bg_color = 15, .flags = flags};
+    GlyphRun run;
+    int32_t x = 30, y = 300;
+
+    memset(expected, 0xFF, FRAMEBUFFER_SIZE);
+    CHECK(layout_text(&FiraSans, long_line, &props, &run));
+    write_glyph_run(&run, &x, &y, expected, BLACK_ON_WHITE, &props);
+    free_glyph_run(&run);
+    int32_t end = x;
+
+    uint32_t before = allocations;
+    memset(framebuffer, 0xFF, FRAMEBUFFER_SIZE);
+    x = 30;
+    write_mode(&FiraSans, long_line, &x, &y, framebuffer, BLACK_ON_WHITE, &props);
+    CHECK(allocations == before);
+    CHECK(x == end);
+    CHECK(memcmp(framebuffer, expected, FRAMEBUFFER_SIZE) == 0);
+}
+
+int main()
+{
+    GlyphCacheStats_t glyph_stats;
+    TextCacheStats_t text_stats;
+    uint32_t seed = 1;
+
+    CHECK(strlen(long_line) > 64);
+    epd_font_init();
+
+    // from here on nothing may allocate
+    uint32_t before = allocations;
+    for (int32_t page = 0; page < PAGE_COUNT; page++)
+    {
+        epd_glyph_cache_clear();
+        epd_text_cache_clear();
+        sample_page_draw(page, 0, expected);
+
+        for (int32_t round = 0; round < 4; round++)
+        {
+            draw_numbers(&seed, 200);
+            walk_glyphs();
+            sample_page_draw(page, 0, framebuffer);
+            CHECK(memcmp(framebuffer, expected, FRAMEBUFFER_SIZE) == 0);
+        }
+    }
+    epd_glyph_cache_get_stats(&glyph_stats);
+    epd_text_cache_get_stats(&text_stats);
+    CHECK(glyph_stats.evictions > 0);
+    CHECK(text_stats.evictions > 0);
+
+    // drawn without a framebuffer: on the screen, across its edges and off it
+    int32_t positions[][2] = {{30, 300}, {EPD_WIDTH - 200, 20}, {-100, EPD_HEIGHT - 5}, {EPD_WIDTH, 300}};
+    for (int32_t i = 0; i < 4; i++)
+    {
+        int32_t x = positions[i][0], y = positions[i][1];
+
+        write_mode(&FiraSans, long_line, &x, &y, NULL, BLACK_ON_WHITE, NULL);
+    }
+    CHECK(allocations == before);
+
+    check_long_line(0);
+    check_long_line(DRAW_COMPOSITE);
+
+    printf("ok\n");
+    return 0;
+}
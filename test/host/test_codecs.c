@@ -0,0 +1,115 @@
+/**
+ * @file test_codecs.c
+ * @brief Check the glyph decoders of the glyph cache: every FiraSans glyph
+ *        decodes to its unpacked bitmap in every codec, truncated streams are
+ *        rejected and corrupt ones are read without running out of bounds.
+ */
+
+#include "host.h"
+#include "codecs.h"
+
+#include "epd_glyph_cache.h"
+
+#include <string.h>
+
+static const enum GlyphCodec codecs[] = {GLYPH_CODEC_NONE, GLYPH_CODEC_ZLIB, GLYPH_CODEC_RLE, GLYPH_CODEC_DEFLATE};
+
+static GFXfont damaged;
+
+static uint32_t unpacked_size(const GFXglyph *glyph)
+{
+    return (glyph->width + 1) / 2 * glyph->height;
+}
+
+/**
+ * @brief Copy a font with its own glyphs and bitmaps, to damage them.
+ */
+static void copy_font(const GFXfont *font)
+{
+    uint32_t count = codec_glyph_count();
+    size_t bytes = codec_flash_bytes(font);
+
+    free(damaged.glyph);
+    free(damaged.bitmap);
+    damaged = *font;
+    damaged.glyph = malloc(count * sizeof(GFXglyph));
+    damaged.bitmap = malloc(bytes);
+    CHECK(damaged.glyph != NULL && damaged.bitmap != NULL);
+    memcpy(damaged.glyph, font->glyph, count * sizeof(GFXglyph));
+    memcpy(damaged.bitmap, font->bitmap, bytes);
+    epd_glyph_cache_clear();
+}
+
+static void check_round_trip(enum GlyphCodec codec)
+{
+    const GFXfont *font = codec_font(codec);
+
+    epd_glyph_cache_clear();
+    for (uint32_t i = 0; i < codec_glyph_count(); i++)
+    {
+        const uint8_t *bitmap = epd_glyph_cache_get(font, &font->glyph[i]);
+        uint32_t size = unpacked_size(&font->glyph[i]);
+
+        CHECK(bitmap != NULL);
+        CHECK(memcmp(bitmap, codec_unpacked(i), size) == 0);
+    }
+}
+
+static void check_truncated(enum GlyphCodec codec, uint32_t *seed)
+{
+    copy_font(codec_font(codec));
+    for (uint32_t i = 0; i < codec_glyph_count(); i++)
+    {
+        GFXglyph *glyph = &damaged.glyph[i];
+
+        if (unpacked_size(glyph) == 0)
+            continue;
+        glyph->compressed_size = host_rand(seed) % glyph->compressed_size;
+        CHECK(epd_glyph_cache_get(&damaged, glyph) == NULL);
+    }
+}
+
+/**
+ * @brief Flip bits and replace whole streams with noise, only the bounds of
+ *        the decoders are checked here, under the sanitizers.
+ */
+static void check_corrupt(enum GlyphCodec codec, uint32_t *seed)
+{
+    const GFXfont *font = codec_font(codec);
+
+    copy_font(font);
+    for (uint32_t i = 0; i < codec_glyph_count(); i++)
+    {
+        GFXglyph *glyph = &damaged.glyph[i];
+        uint8_t *data = &damaged.bitmap[glyph->data_offset];
+
+        for (uint32_t b = 0; b < glyph->compressed_size; b++)
+        {
+            if (i % 2)
+                data[b] = host_rand(seed);
+            else if (host_rand(seed) % 8 == 0)
+                data[b] ^= 1 << (host_rand(seed) % 8);
+        }
+        host_sink += epd_glyph_cache_get(&damaged, glyph) != NULL;
+    }
+}
+
+int main()
+{
+    uint32_t seed = 1;
+
+    for (int32_t c = 0; c < 4; c++)
+        check_round_trip(codecs[c]);
+
+    for (int32_t c = 1; c < 4; c++)
+    {
+        for (int32_t round = 0; round < 4; round++)
+        {
+            check_truncated(codecs[c], &seed);
+            check_corrupt(codecs[c], &seed);
+        }
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file test_draw_char.c
+ * @brief Check `draw_char` from font.c against the old pixel at a time
+ *        renderer: random glyphs in random colors, flat and composite, over
+ *        random buffers of any size, clipped at every edge.
+ */
+
+#include "font.c"
+
+#include "host.h"
+#include "pages.h"
+#include "draw_char_old.h"
+
+#define LABELS 60000
+#define MAX_GLYPHS 8
+#define MAX_BUF_WIDTH 128
+#define MAX_BUF_HEIGHT 80
+#define BUFFER_SIZE (MAX_BUF_WIDTH * MAX_BUF_HEIGHT)
+
+static uint8_t buffer[BUFFER_SIZE];
+static uint8_t expected[BUFFER_SIZE];
+
+int main()
+{
+    const UnicodeInterval *last = &FiraSans.intervals[FiraSans.interval_count - 1];
+    uint32_t glyph_count = last->offset + last->last - last->first + 1;
+    uint32_t seed = 1;
+
+    for (int32_t label = 0; label < LABELS; label++)
+    {
+        uint16_t buf_width = 1 + host_rand(&seed) % MAX_BUF_WIDTH;
+        uint16_t buf_height = 1 + host_rand(&seed) % MAX_BUF_HEIGHT;
+        FontProperties props = {
+            .fg_color = host_rand(&seed) & 0x0F,
+            .bg_color = host_rand(&seed) & 0x0F,
+            .flags = host_rand(&seed) % 2 ? DRAW_COMPOSITE : 0,
+        };
+        int32_t x = (int32_t)(host_rand(&seed) % (2 * buf_width + 80)) - 60;
+        int32_t y = (int32_t)(host_rand(&seed) % (buf_height + 80)) - 20;
+        int32_t old_x = x;
+
+        // a uniform background now and then, composite text takes a shortcut over it
+        for (int32_t i = 0; i < BUFFER_SIZE; i++)
+            buffer[i] = host_rand(&seed);
+        if (host_rand(&seed) % 4 == 0)
+            memset(buffer, (uint8_t)EPD_SWAR_REPEAT(host_rand(&seed)), buf_width * buf_height);
+        memcpy(expected, buffer, BUFFER_SIZE);
+
+        int32_t glyphs = 1 + host_rand(&seed) % MAX_GLYPHS;
+        for (int32_t i = 0; i < glyphs; i++)
+        {
+            const GFXglyph *glyph = &FiraSans.glyph[host_rand(&seed) % glyph_count];
+
+            draw_char(&FiraSans, buffer, &x, y, buf_width, buf_height, glyph, get_style(&props));
+            old_draw_char(&FiraSans, expected, &old_x, y, buf_width, buf_height, glyph, &props);
+        }
+        CHECK(x == old_x);
+        CHECK(memcmp(buffer, expected, BUFFER_SIZE) == 0);
+    }
+
+    printf("ok\n");
+    return 0;
+}
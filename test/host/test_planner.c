@@ -0,0 +1,170 @@
+/**
+ * @file test_planner.c
+ * @brief Check how damage is grouped into passes: close rects share a pass,
+ *        distant ones keep their own, rows equal to the displayed frame cost
+ *        nothing, and every damaged pixel stays covered.
+ */
+
+#include "host.h"
+
+#include "epd_planner.h"
+#include "epd_tiles.h"
+
+#include <string.h>
+
+#define ROW_BYTES (EPD_WIDTH / 2)
+
+static uint8_t framebuffer[ROW_BYTES * EPD_HEIGHT];
+
+/**
+ * @brief Invert the bytes of an area, which must be on screen with even edges.
+ */
+static void toggle(Rect_t area)
+{
+    for (int32_t y = area.y; y < area.y + area.height; y++)
+    {
+        for (int32_t x = area.x; x < area.x + area.width; x += 2)
+            framebuffer[y * ROW_BYTES + x / 2] ^= 0xFF;
+    }
+}
+
+/**
+ * @brief Display a white frame, then change the damaged areas of the next one.
+ */
+static void change(const DamageList_t *damage)
+{
+    TileMask_t changed;
+
+    memset(framebuffer, 0xFF, sizeof(framebuffer));
+    epd_tiles_find_changed(framebuffer, changed);
+    epd_tiles_commit(framebuffer);
+
+    for (int32_t i = 0; i < damage->count; i++)
+        toggle(damage->rects[i]);
+    epd_tiles_find_changed(framebuffer, changed);
+}
+
+static bool contains(Rect_t outer, Rect_t inner)
+{
+    return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width &&
+           inner.y + inner.height <= outer.y + outer.height;
+}
+
+/**
+ * @brief Plan a single rect on its own.
+ */
+static uint32_t single_cost(Rect_t area, int32_t clear_cycles)
+{
+    DamageList_t damage = {.rects = {area}, .count = 1};
+    UpdatePlan_t plan;
+
+    epd_plan_update(&damage, clear_cycles, &plan);
+    return plan.cost_us;
+}
+
+/**
+ * @brief Check what holds for every plan: each rect is covered by a pass, no
+ *        pass is made up, and merging never costs more than separate passes.
+ */
+static void check_plan(const DamageList_t *damage, int32_t clear_cycles, const UpdatePlan_t *plan)
+{
+    uint32_t cost = 0, separate = 0;
+    int32_t covered = 0, damaged = 0;
+
+    CHECK(plan->count >= 1 && plan->count <= damage->count);
+    for (int32_t p = 0; p < plan->count; p++)
+    {
+        cost += plan->passes[p].cost_us;
+        covered += plan->passes[p].covered;
+    }
+    CHECK(plan->cost_us == cost);
+
+    for (int32_t i = 0; i < damage->count; i++)
+    {
+        bool found = false;
+        for (int32_t p = 0; p < plan->count; p++)
+            found |= contains(plan->passes[p].area, damage->rects[i]);
+        CHECK(found);
+
+        damaged += damage->rects[i].width * damage->rects[i].height;
+        separate += single_cost(damage->rects[i], clear_cycles);
+    }
+    CHECK(covered == damaged);
+    CHECK(plan->cost_us <= separate);
+}
+
+int main()
+{
+    UpdatePlan_t plan;
+    uint32_t seed = 1;
+
+    // side by side: one pass instead of two fixed costs
+    DamageList_t near = {.rects = {{.x = 100, .y = 100, .width = 40, .height = 30},
+                                   {.x = 160, .y = 104, .width = 40, .height = 30}},
+                         .count = 2};
+    change(&near);
+    epd_plan_update(&near, 0, &plan);
+    check_plan(&near, 0, &plan);
+    CHECK(plan.count == 1);
+    CHECK(plan.passes[0].area.x == 100 && plan.passes[0].area.width == 100);
+    CHECK(plan.passes[0].rows == 34);
+
+    // top and bottom of the screen: the rows between are unchanged and
+    // skipped, but the overdraw of wide rects outweighs the fixed cost
+    DamageList_t far = {.rects = {{.x = 20, .y = 0, .width = 900, .height = 10},
+                                  {.x = 20, .y = 500, .width = 900, .height = 10}},
+                        .count = 2};
+    change(&far);
+    epd_plan_update(&far, 0, &plan);
+    check_plan(&far, 0, &plan);
+    CHECK(plan.count == 2);
+    CHECK(plan.cost_us == 2 * (EPD_PLAN_PASS_US + 10 * EPD_PLAN_ROW_US));
+
+    // narrow rects far apart are merged, only their changed rows are written
+    DamageList_t narrow = {.rects = {{.x = 20, .y = 0, .width = 40, .height = 10},
+                                     {.x = 20, .y = 500, .width = 40, .height = 10}},
+                           .count = 2};
+    change(&narrow);
+    epd_plan_update(&narrow, 0, &plan);
+    check_plan(&narrow, 0, &plan);
+    CHECK(plan.count == 1);
+    CHECK(plan.passes[0].rows == 20);
+
+    // damage over pixels equal to the displayed frame costs nothing
+    DamageList_t none = {0};
+    change(&none);
+    epd_plan_update(&far, 0, &plan);
+    CHECK(plan.cost_us == 0);
+
+    // flashes write every row of the area, so distant rects stay apart
+    epd_plan_update(&far, 2, &plan);
+    check_plan(&far, 2, &plan);
+    CHECK(plan.count == 2);
+    epd_plan_update(&near, 2, &plan);
+    check_plan(&near, 2, &plan);
+    CHECK(plan.count == 1);
+    CHECK(plan.passes[0].rows == 34);
+
+    for (int32_t i = 0; i < 500; i++)
+    {
+        DamageList_t damage = {.count = 1 + host_rand(&seed) % EPD_DAMAGE_MAX_RECTS};
+
+        for (int32_t r = 0; r < damage.count; r++)
+        {
+            Rect_t *area = &damage.rects[r];
+
+            area->width = 2 * (1 + host_rand(&seed) % 100);
+            area->height = 1 + host_rand(&seed) % 100;
+            area->x = 2 * (host_rand(&seed) % ((EPD_WIDTH - area->width) / 2 + 1));
+            area->y = host_rand(&seed) % (EPD_HEIGHT - area->height + 1);
+        }
+
+        int32_t clear_cycles = i % 2 ? 0 : 1 + host_rand(&seed) % 4;
+        change(&damage);
+        epd_plan_update(&damage, clear_cycles, &plan);
+        check_plan(&damage, clear_cycles, &plan);
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file test_remap.c
+ * @brief Check palette remapping against a pixel at a time reference: areas
+ *        starting or ending on an odd pixel share their edge bytes with
+ *        pixels outside, which must keep their value.
+ */
+
+#include "host.h"
+
+#include "epd_driver.h"
+
+#include <string.h>
+
+#define ROW_BYTES (EPD_WIDTH / 2)
+#define FRAMEBUFFER_SIZE (ROW_BYTES * EPD_HEIGHT)
+
+static uint8_t framebuffer[FRAMEBUFFER_SIZE];
+static uint8_t expected[FRAMEBUFFER_SIZE];
+
+/**
+ * @brief Remap the pixels of an area one at a time, clipped to the screen.
+ */
+static void reference_remap(Rect_t area, const uint8_t *palette, uint8_t *fb)
+{
+    for (int32_t y = area.y; y < area.y + area.height; y++)
+    {
+        for (int32_t x = area.x; x < area.x + area.width; x++)
+        {
+            if (x < 0 || x >= EPD_WIDTH || y < 0 || y >= EPD_HEIGHT)
+                continue;
+
+            uint8_t *byte = &fb[y * ROW_BYTES + x / 2];
+            if (x % 2)
+                *byte = (*byte & 0x0F) | (palette[*byte >> 4] << 4);
+            else
+                *byte = (*byte & 0xF0) | palette[*byte & 0x0F];
+        }
+    }
+}
+
+/**
+ * @brief Remap an area of a random frame through a random palette.
+ */
+static void check_area(Rect_t area, uint32_t *seed)
+{
+    uint8_t palette[16];
+
+    for (int32_t i = 0; i < 16; i++)
+        palette[i] = host_rand(seed) & 0xF;
+    for (int32_t i = 0; i < FRAMEBUFFER_SIZE; i++)
+        framebuffer[i] = host_rand(seed);
+    memcpy(expected, framebuffer, FRAMEBUFFER_SIZE);
+
+    epd_remap_palette_area(area, palette, framebuffer);
+    reference_remap(area, palette, expected);
+    CHECK(memcmp(framebuffer, expected, FRAMEBUFFER_SIZE) == 0);
+}
+
+int main()
+{
+    uint8_t palette[16];
+    uint32_t seed = 1;
+
+    // every combination of odd and even edges, narrower and wider than a word
+    for (int32_t x = 100; x < 102; x++)
+    {
+        for (int32_t width = 1; width <= 20; width++)
+            check_area((Rect_t){.x = x, .y = 40, .width = width, .height = 3}, &seed);
+    }
+
+    // across the screen edges
+    check_area((Rect_t){.x = -3, .y = -5, .width = 14, .height = 12}, &seed);
+    check_area((Rect_t){.x = EPD_WIDTH - 13, .y = EPD_HEIGHT - 4, .width = 30, .height = 9}, &seed);
+    check_area((Rect_t){.x = -1, .y = -1, .width = EPD_WIDTH + 2, .height = EPD_HEIGHT + 2}, &seed);
+    check_area((Rect_t){.x = EPD_WIDTH - 1, .y = 0, .width = 1, .height = 1}, &seed);
+    check_area((Rect_t){.x = -10, .y = 10, .width = 10, .height = 10}, &seed);
+
+    for (int32_t i = 0; i < 200; i++)
+    {
+        Rect_t area = {
+            .x = (int32_t)(host_rand(&seed) % (EPD_WIDTH + 40)) - 20,
+            .y = (int32_t)(host_rand(&seed) % (EPD_HEIGHT + 40)) - 20,
+            .width = 1 + host_rand(&seed) % 200,
+            .height = 1 + host_rand(&seed) % 100,
+        };
+        check_area(area, &seed);
+    }
+
+    // the whole screen
+    for (int32_t i = 0; i < 16; i++)
+        palette[i] = 15 - i;
+    for (int32_t i = 0; i < FRAMEBUFFER_SIZE; i++)
+        framebuffer[i] = host_rand(&seed);
+    memcpy(expected, framebuffer, FRAMEBUFFER_SIZE);
+    epd_remap_palette(palette, framebuffer);
+    reference_remap((Rect_t){.x = 0, .y = 0, .width = EPD_WIDTH, .height = EPD_HEIGHT}, palette, expected);
+    CHECK(memcmp(framebuffer, expected, FRAMEBUFFER_SIZE) == 0);
+
+    printf("ok\n");
+    return 0;
+}
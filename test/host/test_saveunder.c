@@ -0,0 +1,104 @@
+/**
+ * @file test_saveunder.c
+ * @brief Check that a region restores the framebuffer byte for byte: odd edges
+ *        share their byte with the pixel next to them, and areas hanging off
+ *        the screen are clipped.
+ */
+
+#include "host.h"
+
+#include "epd_damage.h"
+#include "epd_saveunder.h"
+
+#include <string.h>
+
+#define ROW_BYTES (EPD_WIDTH / 2)
+#define FRAMEBUFFER_SIZE (ROW_BYTES * EPD_HEIGHT)
+
+static uint8_t framebuffer[FRAMEBUFFER_SIZE];
+static uint8_t expected[FRAMEBUFFER_SIZE];
+
+/**
+ * @brief Set the pixels of an area to a color, clipped to the screen.
+ */
+static void scribble(Rect_t area, uint8_t color)
+{
+    for (int32_t y = area.y; y < area.y + area.height; y++)
+    {
+        for (int32_t x = area.x; x < area.x + area.width; x++)
+        {
+            if (x < 0 || x >= EPD_WIDTH || y < 0 || y >= EPD_HEIGHT)
+                continue;
+
+            uint8_t *byte = &framebuffer[y * ROW_BYTES + x / 2];
+            *byte = x % 2 ? (*byte & 0x0F) | (color << 4) : (*byte & 0xF0) | color;
+        }
+    }
+}
+
+/**
+ * @brief Save an area, draw over it and restore it.
+ */
+static void check_region(Rect_t area, uint32_t *seed)
+{
+    SavedRegion_t region;
+
+    for (int32_t i = 0; i < FRAMEBUFFER_SIZE; i++)
+        framebuffer[i] = host_rand(seed);
+    memcpy(expected, framebuffer, FRAMEBUFFER_SIZE);
+
+    CHECK(epd_save_region(area, framebuffer, &region));
+    CHECK(region.area.x % 2 == 0 && region.area.width % 2 == 0);
+    CHECK(region.area.x >= 0 && region.area.y >= 0);
+    CHECK(region.area.x + region.area.width <= EPD_WIDTH);
+    CHECK(region.area.y + region.area.height <= EPD_HEIGHT);
+
+    scribble(area, host_rand(seed) & 0xF);
+    CHECK(memcmp(framebuffer, expected, FRAMEBUFFER_SIZE) != 0);
+
+    epd_damage_reset();
+    epd_restore_region(&region, framebuffer);
+    CHECK(memcmp(framebuffer, expected, FRAMEBUFFER_SIZE) == 0);
+
+    Rect_t damage = epd_damage_bounds();
+    CHECK(damage.x <= region.area.x && damage.y <= region.area.y);
+    CHECK(damage.x + damage.width >= region.area.x + region.area.width);
+    CHECK(damage.y + damage.height >= region.area.y + region.area.height);
+
+    epd_free_region(&region);
+    CHECK(region.data == NULL);
+}
+
+int main()
+{
+    SavedRegion_t region;
+    uint32_t seed = 1;
+
+    // odd x and odd width, inside and across every edge
+    check_region((Rect_t){.x = 101, .y = 37, .width = 55, .height = 21}, &seed);
+    check_region((Rect_t){.x = 100, .y = 37, .width = 55, .height = 21}, &seed);
+    check_region((Rect_t){.x = -3, .y = -5, .width = 13, .height = 17}, &seed);
+    check_region((Rect_t){.x = EPD_WIDTH - 7, .y = EPD_HEIGHT - 9, .width = 21, .height = 30}, &seed);
+    check_region((Rect_t){.x = -1, .y = -1, .width = EPD_WIDTH + 3, .height = EPD_HEIGHT + 3}, &seed);
+    check_region((Rect_t){.x = EPD_WIDTH - 1, .y = 0, .width = 1, .height = 1}, &seed);
+
+    for (int32_t i = 0; i < 200; i++)
+    {
+        Rect_t area = {
+            .x = (int32_t)(host_rand(&seed) % (EPD_WIDTH + 40)) - 20,
+            .y = (int32_t)(host_rand(&seed) % (EPD_HEIGHT + 40)) - 20,
+            .width = 1 + host_rand(&seed) % 200,
+            .height = 1 + host_rand(&seed) % 100,
+        };
+        if (area.x + area.width <= 0 || area.x >= EPD_WIDTH || area.y + area.height <= 0 || area.y >= EPD_HEIGHT)
+            continue;
+        check_region(area, &seed);
+    }
+
+    // nothing on screen to save
+    CHECK(!epd_save_region((Rect_t){.x = -20, .y = 10, .width = 20, .height = 10}, framebuffer, &region));
+    CHECK(!epd_save_region((Rect_t){.x = 10, .y = EPD_HEIGHT, .width = 20, .height = 10}, framebuffer, &region));
+
+    printf("ok\n");
+    return 0;
+}
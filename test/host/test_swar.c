@@ -0,0 +1,132 @@
+/**
+ * @file test_swar.c
+ * @brief Check every word kernel of epd_swar.h against its pixel at a time
+ *        reference on random data, buffers at every length and offset.
+ */
+
+#include "host.h"
+
+#include "epd_swar.h"
+
+#include <string.h>
+
+#define ROUNDS 100000
+#define MAX_LEN 40
+
+static uint32_t seed = 1;
+
+static uint32_t random_word()
+{
+    return host_rand(&seed) << 8 ^ host_rand(&seed);
+}
+
+/**
+ * @brief A word of mostly few levels, so runs and keys show up like in images.
+ */
+static uint32_t random_pixels()
+{
+    uint32_t word = random_word();
+    uint32_t levels = host_rand(&seed) % 3;
+
+    for (int32_t n = 0; n < 8; n++)
+    {
+        uint32_t pixel = levels == 0 ? (word >> (4 * n)) & 0x0F : levels == 1 ? 0xF * (word >> n & 1) : (word >> n & 1) * 5;
+        word = (word & ~(0xFu << (4 * n))) | pixel << (4 * n);
+    }
+    return word;
+}
+
+/**
+ * @brief A mask of whole nibbles, 0 or 0xF.
+ */
+static uint32_t random_mask()
+{
+    return epd_swar_ref_ne_mask(random_word() & 0x11111111u, 0);
+}
+
+static void random_buffer(uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i += 4)
+    {
+        uint32_t word = random_pixels();
+        for (size_t b = i; b < len && b < i + 4; b++)
+            buf[b] = word >> (8 * (b - i));
+    }
+}
+
+static void test_words()
+{
+    uint8_t lut[256];
+
+    for (int32_t i = 0; i < 256; i++)
+        lut[i] = host_rand(&seed);
+
+    for (int32_t round = 0; round < ROUNDS; round++)
+    {
+        uint32_t a = random_pixels(), b = random_pixels(), mask = random_mask();
+        uint8_t key = host_rand(&seed) & 0x0F, other = host_rand(&seed) & 0x0F;
+
+        CHECK(epd_swar_swap(a) == epd_swar_ref_swap(a));
+        CHECK(epd_swar_shift(a, b & 0x0F) == epd_swar_ref_shift(a, b & 0x0F));
+        CHECK(epd_swar_diff_mask(a, b) == epd_swar_ref_diff_mask(a, b));
+        CHECK(epd_swar_ne_mask(a, key) == epd_swar_ref_ne_mask(a, key));
+        CHECK(epd_swar_select(a, b, mask) == epd_swar_ref_select(a, b, mask));
+        CHECK(epd_swar_expand_bits(a) == epd_swar_ref_expand_bits(a));
+        CHECK(epd_swar_merge_key(a, b, key) == epd_swar_ref_merge_key(a, b, key));
+        CHECK(epd_swar_remap(a, lut) == epd_swar_ref_remap(a, lut));
+        CHECK(epd_swar_swap_levels(a, key, other) == epd_swar_ref_swap_levels(a, key, other));
+    }
+}
+
+static void test_buffers()
+{
+    uint8_t buf[MAX_LEN + 4], ref[MAX_LEN + 4], src[MAX_LEN + 4], bits[MAX_LEN / 4 + 2];
+
+    for (int32_t round = 0; round < ROUNDS; round++)
+    {
+        size_t offset = host_rand(&seed) % 4;
+        size_t len = host_rand(&seed) % MAX_LEN;
+        uint8_t value = host_rand(&seed) & 0x0F, other = host_rand(&seed) & 0x0F;
+        int32_t x = host_rand(&seed) % (2 * MAX_LEN);
+        int32_t count = host_rand(&seed) % (2 * MAX_LEN - x + 1);
+        int32_t shift = 1 + host_rand(&seed) % 7;
+
+        random_buffer(buf, sizeof(buf));
+        random_buffer(src, sizeof(src));
+        for (size_t i = 0; i < sizeof(bits); i++)
+            bits[i] = host_rand(&seed) % 3 ? host_rand(&seed) : host_rand(&seed) % 2 * 0xFF;
+        if (host_rand(&seed) % 2)
+            memset(buf + offset, (uint8_t)EPD_SWAR_REPEAT(value), len);
+
+        CHECK(epd_swar_all_equal(buf + offset, len, value) == epd_swar_ref_all_equal(buf + offset, len, value));
+
+        memcpy(ref, buf, sizeof(buf));
+        epd_swar_swap_buffer(buf + offset, len);
+        epd_swar_ref_swap_buffer(ref + offset, len);
+        CHECK(memcmp(buf, ref, sizeof(buf)) == 0);
+
+        epd_swar_swap_levels_buffer(buf + offset, len, value, other);
+        epd_swar_ref_swap_levels_buffer(ref + offset, len, value, other);
+        CHECK(memcmp(buf, ref, sizeof(buf)) == 0);
+
+        epd_swar_select_bits_buffer(buf + offset, src + offset, bits, offset, len);
+        epd_swar_ref_select_bits_buffer(ref + offset, src + offset, bits, offset, len);
+        CHECK(memcmp(buf, ref, sizeof(buf)) == 0);
+
+        epd_swar_fill(buf, x, count, value);
+        epd_swar_ref_fill(ref, x, count, value);
+        CHECK(memcmp(buf, ref, sizeof(buf)) == 0);
+
+        epd_swar_bit_shift_buffer(buf + offset, len, shift);
+        epd_swar_ref_bit_shift_buffer(ref + offset, len, shift);
+        CHECK(memcmp(buf, ref, sizeof(buf)) == 0);
+    }
+}
+
+int main()
+{
+    test_words();
+    test_buffers();
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file test_text_buffer.c
+ * @brief Check text drawn without a framebuffer, which goes to the panel in
+ *        bands of the text buffer: the bands put together must match the same
+ *        text drawn into a framebuffer, across the screen edges.
+ *
+ * font.c is built with a short text buffer so every line takes several bands,
+ * and the linker wraps `epd_draw_image` to collect them.
+ */
+
+#define EPD_TEXT_BUFFER_ROWS 16
+
+#include "font.c"
+
+#include "host.h"
+#include "pages.h"
+
+#define ROW_BYTES (EPD_WIDTH / 2)
+#define FRAMEBUFFER_SIZE (ROW_BYTES * EPD_HEIGHT)
+
+static const char *const line = "Washing machine: 12 min, 21.5 °C";
+
+static uint8_t framebuffer[FRAMEBUFFER_SIZE];
+static uint8_t panel[FRAMEBUFFER_SIZE];
+static Rect_t drawn;
+static int32_t bands = 0;
+
+static uint8_t get_pixel(const uint8_t *buf, int32_t stride, int32_t x, int32_t y)
+{
+    return (buf[y * stride + x / 2] >> (4 * (x % 2))) & 0x0F;
+}
+
+static void set_pixel(uint8_t *buf, int32_t x, int32_t y, uint8_t value)
+{
+    uint8_t *byte = &buf[y * ROW_BYTES + x / 2];
+    *byte = x % 2 ? (*byte & 0x0F) | value << 4 : (*byte & 0xF0) | value;
+}
+
+/**
+ * @brief Copy a band to the panel image, image rows are padded to whole bytes.
+ */
+void __wrap_epd_draw_image(Rect_t area, uint8_t *data, DrawMode_t mode)
+{
+    (void)mode;
+    CHECK(area.height <= EPD_TEXT_BUFFER_ROWS);
+    CHECK(area.x >= 0 && area.y >= 0 && area.x + area.width <= EPD_WIDTH && area.y + area.height <= EPD_HEIGHT);
+    CHECK(bands == 0 || area.y == drawn.y + drawn.height);
+
+    for (int32_t y = 0; y < area.height; y++)
+    {
+        for (int32_t x = 0; x < area.width; x++)
+            set_pixel(panel, area.x + x, area.y + y, get_pixel(data, (area.width + 1) / 2, x, y));
+    }
+    drawn.height = bands == 0 ? area.height : drawn.height + area.height;
+    drawn.x = area.x;
+    drawn.width = area.width;
+    drawn.y = bands == 0 ? area.y : drawn.y;
+    bands++;
+}
+
+/**
+ * @brief Draw the line with and without a framebuffer, compare the area the
+ *        bands covered.
+ */
+static void check_line(int32_t x, int32_t y, uint32_t flags)
+{
+    FontProperties props = {.fg_color = 2, .bg_color = 13, .flags = flags};
+    int32_t fb_x = x, fb_y = y;
+
+    memset(framebuffer, 0xFF, FRAMEBUFFER_SIZE);
+    memset(panel, 0xFF, FRAMEBUFFER_SIZE);
+    bands = 0;
+    write_mode(&FiraSans, line, &fb_x, &fb_y, framebuffer, BLACK_ON_WHITE, &props);
+    write_mode(&FiraSans, line, &x, &y, NULL, BLACK_ON_WHITE, &props);
+    CHECK(x == fb_x);
+    if (bands == 0)
+        return;
+
+    for (int32_t yy = drawn.y; yy < drawn.y + drawn.height; yy++)
+    {
+        for (int32_t xx = drawn.x; xx < drawn.x + drawn.width; xx++)
+            CHECK(get_pixel(panel, ROW_BYTES, xx, yy) == get_pixel(framebuffer, ROW_BYTES, xx, yy));
+    }
+}
+
+int main()
+{
+    const uint32_t flags[] = {0, DRAW_BACKGROUND, DRAW_COMPOSITE};
+    const int32_t positions[][2] = {
+        {30, 100}, {31, 100}, {-101, 200}, {EPD_WIDTH - 301, 300}, {400, 20}, {400, EPD_HEIGHT + 10},
+    };
+
+    epd_font_init();
+    for (int32_t f = 0; f < 3; f++)
+    {
+        for (int32_t p = 0; p < 6; p++)
+            check_line(positions[p][0], positions[p][1], flags[f]);
+    }
+
+    // a whole line takes several bands, one off the screen takes none
+    check_line(30, 100, 0);
+    CHECK(bands > 1);
+    check_line(EPD_WIDTH, 100, 0);
+    CHECK(bands == 0);
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file test_tiles.c
+ * @brief Check the ghosting a flash resets: only tiles it covers completely,
+ *        with the last tile row and column cut off by the screen edge.
+ */
+
+#include "host.h"
+
+#include "epd_tiles.h"
+
+#include <string.h>
+
+#define ROW_BYTES (EPD_WIDTH / 2)
+
+static uint8_t framebuffer[ROW_BYTES * EPD_HEIGHT];
+
+/**
+ * @brief Invert a tile, clipped to the screen.
+ */
+static void toggle_tile(int32_t tx, int32_t ty)
+{
+    for (int32_t y = ty * EPD_TILE_SIZE; y < (ty + 1) * EPD_TILE_SIZE && y < EPD_HEIGHT; y++)
+    {
+        for (int32_t b = 0; b < EPD_TILE_SIZE / 2; b++)
+            framebuffer[y * ROW_BYTES + tx * EPD_TILE_SIZE / 2 + b] ^= 0xFF;
+    }
+}
+
+static bool is_ghosted(int32_t tx, int32_t ty)
+{
+    TileMask_t ghosted;
+
+    epd_tiles_find_ghosted(ghosted);
+    return ghosted[ty] & (1u << tx);
+}
+
+int main()
+{
+    const int32_t last_x = EPD_TILES_X - 1, last_y = EPD_TILES_Y - 1;
+    TileMask_t changed;
+
+    memset(framebuffer, 0xFF, sizeof(framebuffer));
+    epd_tiles_find_changed(framebuffer, changed);
+    epd_tiles_commit(framebuffer);
+
+    // every draw without a flash charges the changed rows of a tile
+    for (int32_t i = 0; i < 12; i++)
+    {
+        toggle_tile(0, 0);
+        toggle_tile(last_x, last_y);
+        epd_tiles_find_changed(framebuffer, changed);
+        epd_tiles_commit(framebuffer);
+    }
+    CHECK(is_ghosted(0, 0));
+    CHECK(is_ghosted(last_x, last_y));
+
+    // a flash over part of a tile leaves it ghosted, but not known
+    epd_tiles_invalidate((Rect_t){.x = 0, .y = 0, .width = 16, .height = 32});
+    CHECK(is_ghosted(0, 0));
+    epd_tiles_invalidate((Rect_t){.x = 0, .y = 8, .width = 32, .height = 32});
+    CHECK(is_ghosted(0, 0));
+    CHECK(epd_tiles_find_changed(framebuffer, changed) > 0 && (changed[0] & 1));
+
+    epd_tiles_invalidate((Rect_t){.x = -10, .y = -10, .width = 42, .height = 42});
+    CHECK(!is_ghosted(0, 0));
+
+    // the last tile row ends at the screen edge, a flash to the edge covers it
+    epd_tiles_invalidate((Rect_t){.x = last_x * EPD_TILE_SIZE, .y = last_y * EPD_TILE_SIZE,
+                                  .width = EPD_TILE_SIZE, .height = EPD_HEIGHT - last_y * EPD_TILE_SIZE - 1});
+    CHECK(is_ghosted(last_x, last_y));
+    epd_tiles_invalidate((Rect_t){.x = last_x * EPD_TILE_SIZE, .y = last_y * EPD_TILE_SIZE,
+                                  .width = EPD_TILE_SIZE, .height = EPD_HEIGHT - last_y * EPD_TILE_SIZE});
+    CHECK(!is_ghosted(last_x, last_y));
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file test_utf8.c
+ * @brief Check `next_cp` from font.c: valid strings decode as the old decoder
+ *        decoded them, random bytes never run past the terminator and yield
+ *        only scalar values or U+FFFD.
+ */
+
+#include "font.c"
+
+#include "host.h"
+#include "utf8_old.h"
+
+#define VALID_ROUNDS 200000
+#define RANDOM_ROUNDS 1000000
+
+static uint32_t seed = 1;
+
+static int32_t encode(uint32_t c, uint8_t *out)
+{
+    if (c < 0x80)
+    {
+        out[0] = c;
+        return 1;
+    }
+    if (c < 0x800)
+    {
+        out[0] = 0xC0 | c >> 6;
+        out[1] = 0x80 | (c & 0x3F);
+        return 2;
+    }
+    if (c < 0x10000)
+    {
+        out[0] = 0xE0 | c >> 12;
+        out[1] = 0x80 | (c >> 6 & 0x3F);
+        out[2] = 0x80 | (c & 0x3F);
+        return 3;
+    }
+    out[0] = 0xF0 | c >> 18;
+    out[1] = 0x80 | (c >> 12 & 0x3F);
+    out[2] = 0x80 | (c >> 6 & 0x3F);
+    out[3] = 0x80 | (c & 0x3F);
+    return 4;
+}
+
+/**
+ * @brief A scalar value of a random encoded length.
+ */
+static uint32_t random_scalar()
+{
+    uint32_t c;
+
+    do
+    {
+        switch (host_rand(&seed) % 4)
+        {
+        case 0:
+            c = 1 + host_rand(&seed) % 0x7F;
+            break;
+        case 1:
+            c = 0x80 + host_rand(&seed) % 0x780;
+            break;
+        case 2:
+            c = 0x800 + host_rand(&seed) % 0xF800;
+            break;
+        default:
+            c = 0x10000 + host_rand(&seed) % 0x100000;
+            break;
+        }
+    } while (c >= 0xD800 && c <= 0xDFFF);
+    return c;
+}
+
+static void test_valid()
+{
+    for (int32_t round = 0; round < VALID_ROUNDS; round++)
+    {
+        uint8_t text[256];
+        uint32_t scalars[50];
+        int32_t count = host_rand(&seed) % 50, length = 0, i = 0;
+
+        for (int32_t n = 0; n < count; n++)
+        {
+            scalars[n] = random_scalar();
+            length += encode(scalars[n], text + length);
+        }
+        text[length] = 0;
+
+        const uint8_t *old = text, *new = text;
+        uint32_t expected, c;
+        do
+        {
+            expected = old_next_cp(&old);
+            c = next_cp(&new);
+            CHECK(c == expected && new == old);
+            CHECK(c == 0 || c == scalars[i++]);
+        } while (c != 0);
+        CHECK(i == count);
+    }
+}
+
+static void test_random()
+{
+    for (int32_t round = 0; round < RANDOM_ROUNDS; round++)
+    {
+        uint8_t text[17];
+        int32_t length = host_rand(&seed) % 16, steps = 0;
+
+        for (int32_t n = 0; n < length; n++)
+            text[n] = 1 + host_rand(&seed) % 255;
+        text[length] = 0;
+
+        const uint8_t *p = text;
+        uint32_t c;
+        while ((c = next_cp(&p)))
+        {
+            CHECK(p <= text + length && ++steps <= length);
+            CHECK(c <= 0x10FFFF && (c < 0xD800 || c > 0xDFFF));
+        }
+        CHECK(p == text + length);
+    }
+}
+
+/**
+ * @brief Malformed sequences decode to U+FFFD, truncated ones stop before the
+ *        byte that broke them.
+ */
+static void test_malformed()
+{
+    static const struct
+    {
+        const char *text;
+        int32_t consumed;
+    } cases[] = {
+        {"\xC0\xAF", 1},         // lead byte only used for overlong forms
+        {"\xE0\x80\xAF", 3},     // overlong
+        {"\xED\xA0\x80", 3},     // surrogate
+        {"\xF4\x90\x80\x80", 4}, // above U+10FFFF
+        {"\x80", 1},             // stray continuation byte
+        {"\xE2\x9C", 2},         // truncated at the terminator
+        {"\xF0\x9F\x9A" "A", 3}, // truncated before ASCII
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        const uint8_t *p = (const uint8_t *)cases[i].text;
+
+        CHECK(next_cp(&p) == 0xFFFD);
+        CHECK(p == (const uint8_t *)cases[i].text + cases[i].consumed);
+    }
+}
+
+int main()
+{
+    test_valid();
+    test_random();
+    test_malformed();
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file utf8_old.h
+ * @brief The table driven UTF-8 decoder font.c used before `next_cp` validated
+ *        its input, kept as the reference for valid strings.
+ */
+
+#ifndef _UTF8_OLD_H_
+#define _UTF8_OLD_H_
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint8_t  mask;        /* char data will be bitwise AND with this */
+    uint8_t  lead;        /* start bytes of current char in utf-8 encoded character */
+    uint32_t beg;         /* beginning of codepoint range */
+    uint32_t end;         /* end of codepoint range */
+    int32_t  bits_stored; /* the number of bits from the codepoint that fits in char */
+} utf_t;
+
+static utf_t *utf[] = {
+    /*             mask        lead        beg      end       bits */
+    [0] = &(utf_t){0b00111111, 0b10000000, 0,       0,        6},
+    [1] = &(utf_t){0b01111111, 0b00000000, 0000,    0177,     7},
+    [2] = &(utf_t){0b00011111, 0b11000000, 0200,    03777,    5},
+    [3] = &(utf_t){0b00001111, 0b11100000, 04000,   0177777,  4},
+    [4] = &(utf_t){0b00000111, 0b11110000, 0200000, 04177777, 3},
+    &(utf_t){0},
+};
+
+static int32_t old_utf8_len(const uint8_t ch)
+{
+    int32_t len = 0;
+    for (utf_t **u = utf; *u; ++u)
+    {
+        if ((ch & ~(*u)->mask) == (*u)->lead)
+        {
+            break;
+        }
+        ++len;
+    }
+    return len;
+}
+
+static uint32_t old_next_cp(const uint8_t **string)
+{
+    if (**string == 0) return 0;
+
+    int32_t bytes = old_utf8_len(**string);
+    const uint8_t *chr = *string;
+    *string += bytes;
+    int32_t shift = utf[0]->bits_stored * (bytes - 1);
+    uint32_t codep = (*chr++ & utf[bytes]->mask) << shift;
+
+    for (int32_t i = 1; i < bytes; ++i, ++chr)
+    {
+        shift -= utf[0]->bits_stored;
+        codep |= ((uint8_t)*chr & utf[0]->mask) << shift;
+    }
+
+    return codep;
+}
+
+#endif